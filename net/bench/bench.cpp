@@ -0,0 +1,140 @@
+# include <utility>
+
+# include <benchmark/benchmark.h>
+
+# include <netordering/net.hpp>
+
+# include "loadgen.hpp"
+
+/*
+*	Every iteration makes Batch connections to loopback by bench::loadgen.
+*
+*	items_per_second is accepts per second, `p50_us`, `p99_us` and `p999_us` are connect-to-callback latency
+*	percentiles and `cpu_us_per_conn` is CPU time of the whole process(server and load generator together)
+*	per connection.
+*
+*	Results are machine-readable with --benchmark_format=json or --benchmark_out=file.json --benchmark_out_format=json
+*/
+static constexpr std::size_t Batch = 256;
+static constexpr std::size_t Clients = 8;
+
+static void report(benchmark::State& State, net::histogram const& Latency, const std::uint64_t Cpu, bench::loadgen::result const& Result)
+{
+	const net::histogram_snapshot Snapshot = Latency.snapshot();
+	const double Completed = static_cast<double>(std::max<std::uint64_t>(Result.completed, 1));
+
+	State.SetItemsProcessed(static_cast<std::int64_t>(Result.completed));
+	State.counters["p50_us"] = static_cast<double>(Snapshot.percentile(0.5)) / 1e3;
+	State.counters["p99_us"] = static_cast<double>(Snapshot.percentile(0.99)) / 1e3;
+	State.counters["p999_us"] = static_cast<double>(Snapshot.percentile(0.999)) / 1e3;
+	State.counters["cpu_us_per_conn"] = static_cast<double>(Cpu) / 1e3 / Completed;
+	State.counters["failed"] = static_cast<double>(Result.failed);
+}
+
+/*
+*	Pulls connections from listener or queue by one thread and answers one byte
+*/
+template<typename Order>
+class responder final
+{
+	std::atomic<bool> Running;
+	std::thread Thread;
+
+	public:
+		explicit responder(Order& __Order) : Running(true)
+		{
+			Thread = std::thread([this, &__Order](void) -> void {
+				while (Running.load(std::memory_order_acquire))
+					if (std::unique_ptr<net::connection> Connection = __Order.pull_one_for(std::chrono::milliseconds(10)); Connection != nullptr)
+						::send(Connection->socket->native_handle(), "1", 1, MSG_NOSIGNAL);
+			});
+		}
+
+		~responder(void)
+		{
+			Running.store(false, std::memory_order_release);
+			Thread.join();
+		}
+};
+
+template<typename Order>
+static void run(benchmark::State& State, Order& __Order, bench::loadgen const& Generator)
+{
+	responder<Order> Responder(__Order);
+	net::histogram Latency;
+	bench::loadgen::result Total;
+	const std::uint64_t Start = bench::cpu_time();
+
+	for (auto _ : State)
+	{
+		const bench::loadgen::result Result = Generator.run(Batch, Latency);
+
+		Total.completed += Result.completed;
+		Total.failed += Result.failed;
+	}
+	report(State, Latency, bench::cpu_time() - Start, Total);
+}
+
+/*
+*	Args: count of acceptor threads
+*/
+static void BM_listener(benchmark::State& State)
+{
+	net::listener Listener(19100, 0, State.range(0));
+
+	run(State, Listener, bench::loadgen({ 19100 }, Clients));
+}
+BENCHMARK(BM_listener)->ArgName("acceptors")->Arg(1)->Arg(2)->UseRealTime();
+
+/*
+*	Args: count of ports
+*/
+static void BM_queue(benchmark::State& State)
+{
+	net::queue Queue;
+	std::vector<std::uint16_t> Ports;
+
+	for (std::int64_t Index = 0; Index < State.range(0); Index += 1)
+	{
+		Ports.push_back(static_cast<std::uint16_t>(19200 + Index));
+		Queue.add(Ports.back());
+	}
+
+	run(State, Queue, bench::loadgen(Ports, Clients));
+}
+BENCHMARK(BM_queue)->ArgName("ports")->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+/*
+*	Args: LimitExecutor, LimitOrder, lifetime of connection inside callback in microseconds
+*/
+static void BM_server(benchmark::State& State)
+{
+	const std::chrono::microseconds Lifetime(State.range(2));
+	net::histogram Latency;
+	bench::loadgen::result Total;
+
+	net::server Server([Lifetime](std::unique_ptr<net::connection> Connection) -> void {
+		if (Lifetime.count() != 0)
+			std::this_thread::sleep_for(Lifetime);
+		::send(Connection->socket->native_handle(), "1", 1, MSG_NOSIGNAL);
+	}, 19300);
+
+	Server.set_limit_executor(State.range(0));
+	Server.set_limit_order(State.range(1));
+
+	const bench::loadgen Generator({ 19300 }, Clients);
+	const std::uint64_t Start = bench::cpu_time();
+
+	for (auto _ : State)
+	{
+		const bench::loadgen::result Result = Generator.run(Batch, Latency);
+
+		Total.completed += Result.completed;
+		Total.failed += Result.failed;
+	}
+	report(State, Latency, bench::cpu_time() - Start, Total);
+}
+BENCHMARK(BM_server)->ArgNames({ "executors", "order", "lifetime_us" })
+	->ArgsProduct({ { 1, 4 }, { 0, 64 }, { 0, 100 } })->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,113 @@
+# pragma once
+
+# include <cstdint>
+# include <cstddef>
+# include <atomic>
+# include <chrono>
+# include <thread>
+# include <vector>
+
+# include <sys/resource.h>
+# include <sys/socket.h>
+# include <netinet/in.h>
+# include <netinet/tcp.h>
+# include <arpa/inet.h>
+# include <unistd.h>
+
+# include <netordering/metrics.hpp>
+
+namespace bench
+{
+	/*
+	*   client 1  \                           /  port 1
+	*   client 2   >--  connect() ... recv()  --<   port 2
+	*   client N  /                           \  port N
+	*
+	*	Loopback load generator. run(Count) makes Count connections by Clients threads, every thread connects,
+	*	waits for the first byte from the server and resets the connection(SO_LINGER 0, so no TIME_WAIT is left
+	*	and ephemeral ports are not exhausted by long runs). Ports are used round-robin.
+	*
+	*	Latency is connect-to-first-byte in nanoseconds, so it covers accept, order and dispatch to the callback.
+	*/
+	class loadgen final
+	{
+		std::vector<std::uint16_t> Ports;
+		std::size_t Clients;
+
+		public:
+			struct result final
+			{
+				std::uint64_t completed = 0;
+				std::uint64_t failed = 0;
+			};
+
+			loadgen(std::vector<std::uint16_t> __Ports, const std::size_t __Clients) : Ports(std::move(__Ports)), Clients(__Clients)
+			{ }
+
+			result run(const std::size_t Count, net::histogram& Latency) const
+			{
+				std::atomic<std::size_t> Next = 0;
+				std::atomic<std::uint64_t> Completed = 0;
+				std::atomic<std::uint64_t> Failed = 0;
+				std::vector<std::thread> Threads;
+
+				Threads.reserve(Clients);
+				for (std::size_t Index = 0; Index < Clients; Index += 1)
+					Threads.emplace_back([&](void) -> void {
+						for (std::size_t Number = Next.fetch_add(1); Number < Count; Number = Next.fetch_add(1))
+						{
+							const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+							if (once(Ports[Number % Ports.size()]))
+							{
+								Latency.record(static_cast<std::uint64_t>((std::chrono::steady_clock::now() - Start).count()));
+								Completed.fetch_add(1, std::memory_order_relaxed);
+							}
+							else
+								Failed.fetch_add(1, std::memory_order_relaxed);
+						}
+					});
+
+				for (std::thread& Thread : Threads)
+					Thread.join();
+
+				return { Completed.load(), Failed.load() };
+			}
+
+		private:
+			static bool once(const std::uint16_t Port)
+			{
+				const int Descriptor = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+				if (Descriptor == -1)
+					return false;
+
+				sockaddr_in Address = { };
+				Address.sin_family = AF_INET;
+				Address.sin_port = htons(Port);
+				Address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+				char Byte = 0;
+				const bool Result = ::connect(Descriptor, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) == 0
+					&& ::recv(Descriptor, &Byte, 1, 0) == 1;
+
+				const linger Linger = { 1, 0 };
+				::setsockopt(Descriptor, SOL_SOCKET, SO_LINGER, &Linger, sizeof(Linger));
+				::close(Descriptor);
+
+				return Result;
+			}
+	};
+
+	/*
+	*	User and system CPU time of the whole process in nanoseconds
+	*/
+	inline std::uint64_t cpu_time(void)
+	{
+		rusage Usage;
+
+		::getrusage(RUSAGE_SELF, &Usage);
+		return static_cast<std::uint64_t>(Usage.ru_utime.tv_sec + Usage.ru_stime.tv_sec) * 1000000000
+			+ static_cast<std::uint64_t>(Usage.ru_utime.tv_usec + Usage.ru_stime.tv_usec) * 1000;
+	}
+}
@@ -0,0 +1,61 @@
+# pragma once
+
+# include <cstdint>
+# include <cstddef>
+# include <atomic>
+
+namespace net
+{
+	/*
+	*	Token bucket of Rate clients per second which lets Burst of them through at once.
+	*
+	*	It is kept as GCRA(generic cell rate algorithm): the whole state is one time - when the bucket is
+	*	full again, every token moves it Interval = 1 / Rate further. take() is one compare-exchange,
+	*	so acceptor threads of all ports share a bucket without a mutex and nothing is refilled by a timer.
+	*
+	*	Interval and Burst are packed into one word, so take() never sees Interval of one set() with Burst of another.
+	*
+	*	All times are steady_clock nanoseconds. Rate 0 disables the bucket.
+	*/
+	class token_bucket final
+	{
+		/*
+		*	Interval in the high half, Burst in the low one
+		*/
+		std::atomic<std::uint64_t> Settings;
+		std::atomic<std::int64_t> Full;
+
+		public:
+			token_bucket(void);
+
+			explicit token_bucket(token_bucket const&) = delete;
+			explicit token_bucket(token_bucket const&&) = delete;
+
+			/*
+			*	Burst 0 is one second of Rate. Tokens which are taken stay taken, but the bucket is not
+			*	emptier at Now than empty of the new Burst
+			*/
+			void set(const std::size_t Rate, const std::size_t Burst, const std::int64_t Now);
+
+			/*
+			*	set() at the current time
+			*/
+			void set(const std::size_t Rate, const std::size_t Burst);
+
+			std::size_t get_rate(void) const;
+
+			std::size_t get_burst(void) const;
+
+			bool limited(void) const;
+
+			/*
+			*	Takes up to Count tokens at Now, returns how many of them are taken
+			*/
+			std::size_t take(const std::size_t Count, const std::int64_t Now);
+
+			/*
+			*	Gives back tokens which were taken but are not used
+			*/
+			void refund(const std::size_t Count);
+	};
+}
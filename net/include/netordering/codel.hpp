@@ -0,0 +1,53 @@
+# pragma once
+
+# include <cstdint>
+# include <atomic>
+# include <mutex>
+
+namespace net
+{
+	/*
+	*	Controlled Delay(CoDel, RFC 8289) for connections order.
+	*
+	*	drop() is called for every entry which is taken from the order with time which it has spent there(sojourn).
+	*	While sojourn is below Target nothing is dropped. If it stays above Target for Interval, codel enters
+	*	dropping state and drops entries at times Interval / sqrt(count) apart, so the rate of drops grows
+	*	until the order is short again. Entries are never dropped if the order became empty - one slow client
+	*	is not an overload.
+	*
+	*	All times are steady_clock nanoseconds. Target 0 disables codel.
+	*/
+	class codel final
+	{
+		std::atomic<std::int64_t> Target;
+		std::atomic<std::int64_t> Interval;
+		std::mutex Mutex;
+		std::int64_t FirstAboveTime;
+		std::int64_t DropNext;
+		std::uint32_t Count;
+		std::uint32_t LastCount;
+		bool Dropping;
+
+		public:
+			codel(void);
+
+			explicit codel(codel const&) = delete;
+			explicit codel(codel const&&) = delete;
+
+			void set(const std::int64_t __Target, const std::int64_t __Interval);
+
+			std::int64_t get_target(void) const;
+
+			std::int64_t get_interval(void) const;
+
+			/*
+			*	Returns true if entry with given sojourn should be dropped, Empty is whether the order is empty after it
+			*/
+			bool drop(const std::int64_t Sojourn, const std::int64_t Now, const bool Empty);
+
+		private:
+			bool above(const std::int64_t Sojourn, const std::int64_t Now, const bool Empty);
+
+			std::int64_t control(const std::int64_t Time) const;
+	};
+}
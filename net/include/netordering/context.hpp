@@ -0,0 +1,82 @@
+# pragma once
+
+# include <cstddef>
+# include <atomic>
+# include <memory>
+# include <thread>
+# include <vector>
+# include <utility>
+
+# include <boost/asio.hpp>
+
+namespace net
+{
+	/*
+	*	How context_pool chooses io_context for a new connection
+	*/
+	enum class balance
+	{
+		round_robin,
+		least_load
+	};
+
+	/*
+	*                      *---------------------------*
+	*                      | slot 1: io_context+thread |
+	*   acquire()   <--    | slot 2: io_context+thread |
+	*                      | ...                       |
+	*                      | slot N: io_context+thread |
+	*                      *---------------------------*
+	*
+	*	Pool of io_contexts, one per core by default. Every io_context is run by its own thread all the time,
+	*	so async operations which are started on connection's socket are really executed.
+	*
+	*	acquire() returns slot for a new connection - by round-robin or by least count of living connections(set_balance()).
+	*	Slot is held by shared_ptr, so io_context is alive while some connection is using it, even after pool is destroyed.
+	*
+	*	shared() is a process-wide pool which is used by listeners by default.
+	*/
+	class context_pool final
+	{
+		public:
+			struct slot final
+			{
+				boost::asio::io_context context;
+				std::atomic<std::size_t> load;
+
+				slot(void) : context(1), load(0)
+				{ }
+			};
+
+		private:
+			std::atomic<std::size_t> Next;
+			std::atomic<balance> Balance;
+			std::vector<std::thread> Threads;
+			std::vector<std::shared_ptr<slot>> Slots;
+			std::vector<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> Guards;
+
+		public:
+			context_pool(void);
+
+			explicit context_pool(const std::size_t Size);
+
+			explicit context_pool(context_pool const&) = delete;
+			explicit context_pool(context_pool const&&) = delete;
+
+			~context_pool(void);
+
+			[[ nodiscard ]]
+			std::shared_ptr<slot> acquire(void);
+
+			std::size_t size(void) const;
+
+			void set_balance(const balance __Balance);
+
+			balance get_balance(void) const;
+
+			static std::shared_ptr<context_pool> shared(void);
+
+		private:
+			void launch(const std::size_t Size);
+	};
+}
@@ -0,0 +1,166 @@
+# pragma once
+
+# include <netordering/payload.hpp>
+
+# include <initializer_list>
+# include <unordered_map>
+# include <algorithm>
+# include <string_view>
+# include <cstdint>
+# include <cstddef>
+# include <cstring>
+# include <memory>
+# include <string>
+# include <array>
+# include <mutex>
+# include <span>
+# include <list>
+
+namespace net
+{
+	enum class algorithm
+	{
+		md5,
+		sha1,
+		sha256,
+		sha512
+	};
+
+	/*
+	*	Writes 2 * Bytes.size() lowercase hex characters to Out, 16 bytes at a time by SSE2 where it is available.
+	*	Returns count of written characters
+	*/
+	std::size_t hex(std::span<const unsigned char> Bytes, char* Out);
+
+	/*
+	*	Result of hashing, kept by value: nothing is allocated until hex() or etag() is asked for a string
+	*/
+	struct digest final
+	{
+		static constexpr std::size_t MaxSize = 64;
+
+		std::array<unsigned char, MaxSize> bytes;
+		std::uint32_t size;
+
+		std::string hex(void) const;
+
+		/*
+		*	Strong entity tag: hex in quotes
+		*/
+		std::string etag(void) const;
+
+		/*
+		*	Whether value of If-None-Match header has etag() of this digest, weak tags(W/) and "*" match too
+		*/
+		bool matches(std::string_view IfNoneMatch) const;
+
+		bool operator==(digest const& Other) const
+		{
+			return size == Other.size && std::memcmp(bytes.data(), Other.bytes.data(), size) == 0;
+		}
+	};
+
+	/*
+	*	Streaming hash: update() may be called for every buffer of connection, finish() gives the digest and
+	*	starts a new one of the same algorithm.
+	*	OpenSSL context is taken from the cache of the thread and returned to it by destructor,
+	*	so a hasher per request does not allocate. Instance is used by one thread
+	*/
+	class hasher final
+	{
+		void* Context;
+		algorithm Algorithm;
+
+		public:
+			explicit hasher(const algorithm __Algorithm);
+
+			explicit hasher(hasher const&) = delete;
+			explicit hasher(hasher const&&) = delete;
+
+			~hasher(void);
+
+			hasher& update(const std::string_view Data);
+
+			hasher& update(buffer const& Buffer);
+
+			hasher& update(std::initializer_list<std::string_view> Parts);
+
+			hasher& update(std::span<const std::string_view> Parts);
+
+			/*
+			*	Contents of File from the beginning, read by pooled buffers
+			*/
+			hasher& update(file const& File);
+
+			digest finish(void);
+	};
+
+	digest hash(const algorithm Algorithm, const std::string_view Data);
+
+	/*
+	*	Digests of many small payloads by one context, Results[Index] is digest of Payloads[Index].
+	*	Results must be at least as long as Payloads
+	*/
+	void hash(const algorithm Algorithm, std::span<const std::string_view> Payloads, std::span<digest> Results);
+
+	struct digest_hash final
+	{
+		std::size_t operator()(digest const& Digest) const
+		{
+			std::size_t Result = 0;
+
+			// Bytes of a digest are uniform already
+			std::memcpy(&Result, Digest.bytes.data(), std::min<std::size_t>(sizeof(Result), Digest.size));
+			return Result;
+		}
+	};
+
+	/*
+	*	Rendered responses keyed by digest of their content, least recently used one is evicted after Capacity.
+	*	Responses are shared, so they may be written while being evicted
+	*/
+	class response_cache final
+	{
+		struct cached final
+		{
+			digest Key;
+			std::shared_ptr<const std::string> Response;
+		};
+
+		std::size_t Capacity;
+		std::mutex Mutex;
+		std::list<cached> Order;
+		std::unordered_map<digest, std::list<cached>::iterator, digest_hash> Index;
+
+		public:
+			explicit response_cache(const std::size_t __Capacity);
+
+			explicit response_cache(response_cache const&) = delete;
+			explicit response_cache(response_cache const&&) = delete;
+
+			/*
+			*	nullptr if there is no response for Key
+			*/
+			std::shared_ptr<const std::string> find(digest const& Key);
+
+			/*
+			*	Replaces response of Key if there is one
+			*/
+			std::shared_ptr<const std::string> insert(digest const& Key, std::string Response);
+
+			/*
+			*	Cached response of Key or the one which Render() returns, Render is called without lock
+			*/
+			template<typename Function>
+			std::shared_ptr<const std::string> get(digest const& Key, Function&& Render)
+			{
+				if (std::shared_ptr<const std::string> Result = find(Key); Result != nullptr)
+					return Result;
+				return insert(Key, Render());
+			}
+
+			std::size_t size(void);
+
+			void clear(void);
+	};
+}
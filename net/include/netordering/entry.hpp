@@ -0,0 +1,35 @@
+# pragma once
+
+# include <cstdint>
+# include <array>
+
+namespace net
+{
+	/*
+	*	Entry of connections order - accepted socket which is not wrapped into net::connection yet.
+	*
+	*	Orders are keeping these plain entries in their rings, so connection which is rejected by Limit or LimitOrder
+	*	costs no allocation. net::connection is built from entry only when it is pulled by pull_one().
+	*
+	*	`descriptor` is native socket handle, order owns it until entry is pulled
+	*	`port` is local port which connection was accepted on
+	*	`accepted` is steady_clock time of accept in nanoseconds
+	*	`family` is 4 or 6, `peer_address`(first 4 bytes for IPv4) and `peer_port` are remote endpoint,
+	*	address and port are zero if the socket is accepted by io_uring
+	*	`uring` is whether connection does its I/O through io_uring, see net::backend
+	*	`prefetched` is block of net::buffer with first `prefetched_size` bytes of the client which listener has
+	*	read already(see listener::set_prefetch()), order owns it with the descriptor
+	*/
+	struct entry final
+	{
+		int descriptor = -1;
+		std::uint16_t port = 0;
+		std::uint16_t peer_port = 0;
+		std::uint8_t family = 0;
+		std::array<std::uint8_t, 16> peer_address = { };
+		std::int64_t accepted = 0;
+		bool uring = false;
+		std::uint32_t prefetched_size = 0;
+		char* prefetched = nullptr;
+	};
+}
@@ -0,0 +1,116 @@
+# pragma once
+
+# include <shared_mutex>
+# include <functional>
+# include <chrono>
+# include <cstddef>
+# include <atomic>
+# include <memory>
+# include <thread>
+# include <vector>
+# include <deque>
+# include <mutex>
+
+# include <netordering/notifier.hpp>
+
+namespace net
+{
+	struct connection;
+
+	/*
+	*                 *-------------------*
+	*                 | worker 1: deque   |  <-.
+	*   submit() -->  | worker 2: deque   |    |  idle worker steals from others
+	*                 | ...               |    |
+	*                 | worker N: deque   |  --'
+	*                 *-------------------*
+	*
+	*	Fixed pool of threads which are calling the handler for every submitted connection.
+	*	Threads are created once, submit() does not allocate a thread or a future.
+	*
+	*	submit() puts connection to the deque of the next worker(round-robin).
+	*	Worker takes connections from the front of its own deque and, if it is empty,
+	*	steals from the front of the others - so the oldest connection is served first.
+	*
+	*	available() is count of workers which are not busy now, so caller can keep
+	*	connections in its own order instead of piling them up here.
+	*
+	*	You can change count of workers in runtime by resize(). Extra workers are finishing
+	*	their current connection and exit, their deques are stolen by the others.
+	*
+	*	Exceptions from the handler are swallowed, one bad connection does not kill the worker.
+	*/
+	class executor final
+	{
+		struct worker final
+		{
+			std::mutex Mutex;
+			std::thread Thread;
+			bool Retired = true;
+			std::deque<std::unique_ptr<connection>> Deque;
+		};
+
+		notifier Work;
+		notifier Idle;
+		notifier Released;
+		std::atomic<bool> Stopping;
+		std::atomic<std::size_t> Next;
+		std::atomic<std::size_t> Busy;
+		std::atomic<std::size_t> Size;
+		std::shared_mutex WorkersMutex;
+		std::vector<std::unique_ptr<worker>> Workers;
+		std::function<void(std::unique_ptr<connection>)> Handler;
+
+		public:
+			explicit executor(std::function<void(std::unique_ptr<connection>)> __Handler, const std::size_t __Size);
+
+			explicit executor(executor const&) = delete;
+			explicit executor(executor const&&) = delete;
+
+			~executor(void);
+
+			void submit(std::unique_ptr<connection> Connection);
+
+			void resize(std::size_t __Size);
+
+			std::size_t size(void) const;
+
+			std::size_t busy(void) const;
+
+			std::size_t available(void) const;
+
+			/*
+			*	Sleeps until some worker is free or Cancel() returns true
+			*/
+			template<typename Predicate>
+			void wait_available(Predicate Cancel)
+			{
+				const std::size_t Epoch = Released.epoch();
+
+				if (available() != 0 || Cancel())
+					return;
+				Released.wait([&](void) -> bool {
+					return Released.epoch() != Epoch || available() != 0 || Cancel();
+				});
+			}
+
+			/*
+			*	Sleeps until no worker is busy or Deadline, false if workers are still busy
+			*/
+			template<typename Clock, typename Duration>
+			bool wait_idle(const std::chrono::time_point<Clock, Duration>& Deadline)
+			{
+				return Idle.wait_until(Deadline, [this](void) -> bool { return busy() == 0; });
+			}
+
+			/*
+			*	Wakes up everyone who is inside wait_available()
+			*/
+			void interrupt(void);
+
+		private:
+			void work(const std::size_t Index);
+
+			std::unique_ptr<connection> take(const std::size_t Index);
+	};
+}
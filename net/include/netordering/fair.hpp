@@ -0,0 +1,117 @@
+# pragma once
+
+# include <netordering/entry.hpp>
+
+# include <optional>
+# include <cstdint>
+# include <cstddef>
+# include <atomic>
+# include <vector>
+# include <deque>
+# include <mutex>
+
+namespace net
+{
+	/*
+	*                           *-----------------------*
+	*   push()  --hash(peer)->  | bucket 0: e -> e -> e |  <-.
+	*                           | bucket 1: e           |    |  pop() takes one client of every
+	*                           | ...                   |    |  non-empty bucket in turn
+	*                           | bucket N: e -> e      |  --'
+	*                           *-----------------------*
+	*
+	*	Stochastic fair order of clients by their source. Peer address(/64 prefix for IPv6, IPv4 address for
+	*	IPv4-mapped IPv6) is hashed with a random salt into one of a fixed count of buckets, so memory does not grow
+	*	with count of distinct sources: sources which share a bucket share its turn too. Salt is chosen again by
+	*	every configure().
+	*
+	*	Cap is count of clients of one bucket which are queued or alive after pop() - ticket of a popped client is
+	*	released by its connection. Client over the cap is rejected. When the whole order is at Limit, client of
+	*	a shorter bucket pushes out the oldest client of the longest one, so the source which holds most of the order
+	*	is the one which is rejected.
+	*
+	*	Entries are kept in one pool of linked nodes which are reused, it is as large as the longest order has been.
+	*	All methods take the mutex, size() and enabled() do not.
+	*/
+	class fair_queue final
+	{
+		static constexpr std::uint32_t Nil = 0xffffffff;
+
+		struct node final
+		{
+			entry Entry;
+			std::uint32_t Next;
+		};
+
+		struct bucket final
+		{
+			std::uint32_t Head = Nil;
+			std::uint32_t Tail = Nil;
+			std::uint32_t Length = 0;
+			std::uint32_t Active = 0;
+			bool Listed = false;
+		};
+
+		std::mutex Mutex;
+		std::vector<node> Nodes;
+		std::uint32_t Free;
+		std::vector<bucket> Buckets;
+		std::deque<std::uint32_t> Round;
+		std::atomic<std::size_t> Size;
+		std::atomic<std::size_t> Count;
+		std::size_t Cap;
+		std::uint64_t Salt;
+		std::uint64_t Generation;
+
+		public:
+			/*
+			*	Bucket of a popped client, it is released once
+			*/
+			struct ticket final
+			{
+				std::uint32_t bucket = Nil;
+				std::uint64_t generation = 0;
+			};
+
+			fair_queue(void);
+
+			explicit fair_queue(fair_queue const&) = delete;
+			explicit fair_queue(fair_queue const&&) = delete;
+
+			~fair_queue(void);
+
+			/*
+			*	Count 0 disables the order: push() is not called by net::queue, clients which are queued are still popped.
+			*	Queued clients are spread into the new buckets, tickets of the previous configuration are ignored
+			*/
+			void configure(const std::size_t __Count, const std::size_t __Cap);
+
+			bool enabled(void) const;
+
+			std::size_t buckets(void) const;
+
+			std::size_t get_cap(void) const;
+
+			/*
+			*	Queues clients of Batch while total count is below Limit(0 is unlimited). Batch is reordered:
+			*	the first returned count of entries are queued, the rest are rejected and pushed-out ones,
+			*	caller rejects them
+			*/
+			std::size_t push(std::vector<entry>& Batch, const std::size_t Limit);
+
+			std::optional<entry> pop(ticket& Ticket);
+
+			void release(ticket const& Ticket);
+
+			std::size_t size(void) const;
+
+		private:
+			std::uint32_t index(entry& Entry) const;
+
+			void append(const std::uint32_t Index, entry const& Entry);
+
+			entry take(const std::uint32_t Index);
+
+			std::uint32_t longest(void) const;
+	};
+}
@@ -0,0 +1,66 @@
+# pragma once
+
+# include <string>
+# include <vector>
+# include <chrono>
+# include <cstddef>
+# include <map>
+
+namespace net
+{
+	/*
+	*   old process                                    new process
+	*   server::hand_over(Path)  --SCM_RIGHTS-->  net::inherit(Path)  -->  net::server(Callback, Sockets, Ports...)
+	*
+	*	Listening sockets which are taken from another process, grouped by their port. They are the same sockets,
+	*	not copies: clients which are in the backlog during restart are accepted by the new process, none is refused.
+	*
+	*	Descriptors which are not taken by a listener are closed by destructor.
+	*/
+	class inherited final
+	{
+		std::map<std::size_t, std::vector<int>> Sockets;
+
+		public:
+			inherited(void) = default;
+
+			inherited(inherited&& Other) noexcept;
+
+			inherited& operator=(inherited&& Other) noexcept;
+
+			explicit inherited(inherited const&) = delete;
+
+			~inherited(void);
+
+			/*
+			*	Takes Descriptor if it is a listening TCP socket, otherwise returns false and does not touch it
+			*/
+			bool add(const int Descriptor);
+
+			/*
+			*	Descriptors of Port, caller owns them after the call
+			*/
+			std::vector<int> take(const std::size_t Port);
+
+			std::vector<std::size_t> ports(void) const;
+
+			std::size_t size(void) const;
+
+			bool empty(void) const;
+
+		private:
+			void release(void);
+	};
+
+	/*
+	*	Connects to Unix socket Path where the old process is in server::hand_over(), retrying up to Timeout.
+	*	Empty if there is no such process, so the first start binds its ports as usual
+	*/
+	inherited inherit(std::string const& Path, const std::chrono::milliseconds Timeout = std::chrono::milliseconds(1000));
+
+	/*
+	*	systemd socket activation: descriptors from 3 which LISTEN_FDS and LISTEN_PID pass to this process.
+	*	Variables are removed from environment, so child processes do not take the same descriptors
+	*/
+	inherited inherit_systemd(void);
+}
@@ -0,0 +1,123 @@
+# pragma once
+
+# include <netordering/net.hpp>
+
+# include <string_view>
+# include <type_traits>
+# include <functional>
+# include <cstdint>
+# include <cstddef>
+# include <memory>
+# include <array>
+
+namespace net
+{
+	struct header final
+	{
+		std::string_view name;
+		std::string_view value;
+	};
+
+	/*
+	*	HTTP/1.x request which is parsed in place: all views point into the bytes which were given to parse(),
+	*	so it is valid while they are. Nothing is allocated, headers are kept in the fixed array.
+	*
+	*	size is count of bytes of the request including body, the next pipelined request starts after them.
+	*	If parse() returns framing::partial after the whole header section, size is count of bytes which the request
+	*	needs, it is 0 if the header section is not complete yet
+	*/
+	struct request_view final
+	{
+		static constexpr std::size_t MaxHeaders = 64;
+
+		std::string_view method;
+		std::string_view target;
+		int minor_version;
+		std::array<net::header, MaxHeaders> headers;
+		std::size_t header_count;
+		std::string_view body;
+		bool keep_alive;
+		std::size_t size;
+
+		/*
+		*	Value of the first header with Name(case-insensitive), empty if there is no such header
+		*/
+		std::string_view header(const std::string_view Name) const;
+	};
+
+	/*
+	*	`complete` - request and its body(Content-Length) are in Data
+	*	`partial` - Data ends inside of the request, more bytes are needed
+	*	`invalid` - malformed request line or header, answer is 400
+	*	`too_large` - more than request_view::MaxHeaders headers, answer is 431
+	*	`unsupported` - body has Transfer-Encoding, answer is 501
+	*/
+	enum class framing
+	{
+		complete,
+		partial,
+		invalid,
+		too_large,
+		unsupported
+	};
+
+	/*
+	*	How parse() looks for line ends and delimiters. By default it is the widest one which CPU has(checked once
+	*	per process). set_scan() returns false and keeps the current one if CPU does not have Kind
+	*/
+	enum class scan
+	{
+		scalar,
+		sse42,
+		avx2
+	};
+
+	bool set_scan(const scan Kind);
+
+	scan get_scan(void);
+
+	/*
+	*	Parses one request from the beginning of Data, see net::scan.
+	*	Request is filled only if result is framing::complete, except request_view::size
+	*/
+	framing parse(const std::string_view Data, request_view& Request);
+
+	/*
+	*	Framing loop of http(): reads requests of Connection and calls Handler for every one of them, pipelined
+	*	requests are handled in order. When all bytes are handled the connection is parked(see net::park()),
+	*	it is closed if Handler returns false or the request is malformed.
+	*	Request has to fit into one net::buffer: header section which does not is answered by 431, body by 413
+	*/
+	void frame(std::unique_ptr<connection> Connection, std::function<bool(connection&, request_view const&)> const& Handler);
+
+	/*
+	*	Framing stage for net::server: wraps Handler(connection&, request_view const&) into a connection callback.
+	*	If Handler returns bool it tells whether to keep the connection, otherwise request_view::keep_alive does.
+	*
+	*	Example:
+	*		net::server Server(net::http([](net::connection& Connection, net::request_view const& Request) -> void {
+	*			boost::system::error_code Error;
+	*
+	*			Connection.write({ "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nOK" }, Error);
+	*		}), 80);
+	*/
+	template<typename Handler>
+	std::function<void(std::unique_ptr<connection>)> http(Handler __Handler)
+	{
+		static_assert(std::is_invocable_v<Handler&, connection&, request_view const&>, "Given handler can not be called with connection and request");
+
+		std::function<bool(connection&, request_view const&)> Callback = [__Handler = std::move(__Handler)](connection& Connection, request_view const& Request) mutable -> bool {
+			if constexpr (std::is_same_v<std::invoke_result_t<Handler&, connection&, request_view const&>, bool>)
+				return __Handler(Connection, Request);
+			else
+			{
+				__Handler(Connection, Request);
+				return Request.keep_alive;
+			}
+		};
+
+		return [Callback = std::move(Callback)](std::unique_ptr<connection> Connection) -> void {
+			frame(std::move(Connection), Callback);
+		};
+	}
+}
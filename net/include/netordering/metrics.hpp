@@ -0,0 +1,144 @@
+# pragma once
+
+# include <string_view>
+# include <cstdint>
+# include <cstddef>
+# include <atomic>
+# include <string>
+# include <vector>
+# include <array>
+
+namespace net
+{
+	/*
+	*	Why client was not put into the order
+	*
+	*	`limit`    - Limit of listener is reached
+	*	`order`    - LimitOrder of queue is reached, or the source of client is over its cap of the fair order
+	*	`overflow` - one of above, but net::rejector was full too and client got RST instead of the policy
+	*	`rate`     - token bucket of the port or of the queue is empty(see net::token_bucket)
+	*/
+	enum class reason
+	{
+		limit,
+		order,
+		overflow,
+		rate
+	};
+
+	/*
+	*	Snapshot of net::histogram, see there
+	*/
+	struct histogram_snapshot final
+	{
+		std::uint64_t count = 0;
+		std::uint64_t sum = 0;
+		std::uint64_t max = 0;
+		std::vector<std::uint64_t> buckets;
+
+		/*
+		*	Upper bound of the bucket which has Quantile(0..1) of values, 0 if histogram is empty
+		*/
+		std::uint64_t percentile(const double Quantile) const;
+
+		/*
+		*	Count of values which are less than Bound. It is exact if Bound is a power of two
+		*/
+		std::uint64_t below(const std::uint64_t Bound) const;
+	};
+
+	/*
+	*	Lock-free log-linear histogram of nanoseconds(HDR-style).
+	*
+	*	Every power of two is split to 8 buckets, so relative error is not greater than 12.5%
+	*	on the whole range of std::uint64_t. record() is three relaxed increments and
+	*	a compare-exchange only when maximum grows.
+	*/
+	class histogram final
+	{
+		public:
+			static constexpr std::size_t SubBits = 3;
+			static constexpr std::size_t Sub = std::size_t(1) << SubBits;
+			static constexpr std::size_t Buckets = (64 - SubBits + 1) * Sub;
+
+		private:
+			std::array<std::atomic<std::uint64_t>, Buckets> Counts;
+			std::atomic<std::uint64_t> Count;
+			std::atomic<std::uint64_t> Sum;
+			std::atomic<std::uint64_t> Max;
+
+		public:
+			histogram(void);
+
+			explicit histogram(histogram const&) = delete;
+			explicit histogram(histogram const&&) = delete;
+
+			void record(const std::uint64_t Value);
+
+			histogram_snapshot snapshot(void) const;
+
+			static std::size_t index(const std::uint64_t Value);
+
+			/*
+			*	The greatest value which falls to bucket Index
+			*/
+			static std::uint64_t upper(const std::size_t Index);
+	};
+
+	/*
+	*	Counters of one port, they are incremented by acceptor and background threads with relaxed atomics
+	*/
+	struct port_counters final
+	{
+		std::atomic<std::uint64_t> accepted = 0;
+		std::array<std::atomic<std::uint64_t>, 4> rejected = { };
+
+		void reject(const reason Reason, const std::uint64_t Count)
+		{
+			rejected[static_cast<std::size_t>(Reason)].fetch_add(Count, std::memory_order_relaxed);
+		}
+	};
+
+	struct port_metrics final
+	{
+		std::size_t port = 0;
+		std::uint64_t accepted = 0;
+		std::array<std::uint64_t, 4> rejected = { };
+		std::size_t depth = 0;
+		std::size_t limit = 0;
+	};
+
+	/*
+	*	Snapshot which is returned by snapshot() of net::queue and net::server
+	*
+	*	`ports` are counters of every listener
+	*	`depth` and `limit` are size of the order and LimitOrder
+	*	`busy` and `executors` are count of running handlers and LimitExecutor(server only)
+	*	`parked` is count of keep-alive connections which are waiting for the next request(server only)
+	*	`expired` and `dropped` are clients which have been too old for max age and dropped by CoDel
+	*	`queue_wait` is time from accept to dispatch to a handler, `handler` is duration of handler(server only)
+	*/
+	struct metrics final
+	{
+		std::vector<port_metrics> ports;
+		std::size_t depth = 0;
+		std::size_t limit = 0;
+		std::size_t busy = 0;
+		std::size_t executors = 0;
+		std::size_t parked = 0;
+		std::uint64_t expired = 0;
+		std::uint64_t dropped = 0;
+		histogram_snapshot queue_wait;
+		histogram_snapshot handler;
+	};
+
+	/*
+	*	Adds counters and histograms of From to Into, ports with the same number are summed
+	*/
+	void merge(metrics& Into, metrics const& From);
+
+	/*
+	*	Prometheus text exposition format of Metrics, names are started with Prefix
+	*/
+	std::string prometheus(metrics const& Metrics, const std::string_view Prefix = "netordering");
+}
@@ -8,27 +8,73 @@
 # include <memory>
 # include <thread>
 # include <future>
-# include <queue>
+# include <condition_variable>
+# include <utility>
+# include <limits>
+# include <functional>
+# include <optional>
+# include <exception>
+# include <cstdint>
+# include <chrono>
+# include <array>
+# include <unordered_map>
+# include <initializer_list>
+# include <span>
 
 # include <boost/asio.hpp>
 
-constexpr std::string_view ErrorMessage = "Sorry";
+# include <netordering/notifier.hpp>
+# include <netordering/executor.hpp>
+# include <netordering/context.hpp>
+# include <netordering/ring.hpp>
+# include <netordering/entry.hpp>
+# include <netordering/rejector.hpp>
+# include <netordering/metrics.hpp>
+# include <netordering/codel.hpp>
+# include <netordering/bucket.hpp>
+# include <netordering/payload.hpp>
+# include <netordering/digest.hpp>
+# include <netordering/uring.hpp>
+# include <netordering/parking.hpp>
+# include <netordering/handoff.hpp>
+# include <netordering/fair.hpp>
 
 namespace net
 {
+# ifdef SO_REUSEPORT
+	using reuse_port = boost::asio::detail::socket_option::boolean<BOOST_ASIO_OS_DEF(SOL_SOCKET), SO_REUSEPORT>;
+# endif
+
 	/*
-	*		*------------------------------*
-	*		| connection:                  |
-	*		| -> unique_ptr<socket> Socket |
-	*		| -> unique_ptr<socket> ios    |
-	*		| #  const size_t Port         |
-	*		*------------------------------*
+	*		*-------------------------------*
+	*		| connection:                   |
+	*		| -> shared_ptr<slot> slot      |
+	*		| -> optional<socket> socket    |
+	*		| #  const size_t port          |
+	*		| #  const time_point accepted  |
+	*		*-------------------------------*
 	* 
 	*	Pointer to this structure is a return type of pull_one()
 	*	
-	*	`socket` has type std::unique_ptr<boost::asio::ip::tcp::socket>
-	*	`ios` has type std::unique_ptr<boost::asio::io_service>
+	*	`slot` has type std::shared_ptr<net::context_pool::slot> - io_context from the shared pool which socket belongs to
+	*	`socket` has type std::optional<boost::asio::ip::tcp::socket> - use it like pointer: *Connection->socket, Connection->socket->close()
 	*	`port` has type const std::size_t
+	*	`accepted` has type const std::chrono::steady_clock::time_point - when listener has accepted this connection
+	* 
+	*	io_context of the slot is always running by the pool thread, so you can start async operations on socket
+	*	with get_executor(). Keep unique_ptr<connection> alive(move it into your completion handler) until they are done.
+	* 
+	*	Memory for connections is taken from a free-list(operator new of this structure), so
+	*	pull_one() does not go to the allocator for every client.
+	* 
+	*	Besides the socket there is a copy-free I/O:
+	*	read() reads into pooled net::buffer, write() is gathered writev() of several parts,
+	*	sendfile() sends net::file without reading it and send_zerocopy() sends large data with MSG_ZEROCOPY.
+	*	They are blocking, like write_some() of the socket.
+	*	Connections which are accepted by backend::io_uring do read() and write() through io_uring of the calling thread.
+	* 
+	*	Handler of net::server may keep the connection alive by net::park(std::move(Connection)) instead of
+	*	destroying it - the server calls the handler again when the next request is readable.
 	* 
 	*	Note that you have freedom working with this instance.
 	*   You can distruct them or something else. Listener is have not access for this object after pull_one()
@@ -36,139 +82,469 @@ namespace net
 	*/
 	struct connection final
 	{
-		std::unique_ptr<boost::asio::io_service> ios = nullptr;
-		std::unique_ptr<boost::asio::ip::tcp::socket> socket = nullptr;
+		std::shared_ptr<context_pool::slot> slot = nullptr;
+		std::optional<boost::asio::ip::tcp::socket> socket;
 		const std::size_t port;
+		const std::chrono::steady_clock::time_point accepted;
+
+		static constexpr std::size_t ZeroCopyThreshold = 16384;
 
 		connection(void) = default;
 		template<typename Type>
-		explicit connection(const Type __Port): port(__Port)
+		explicit connection(const Type __Port): port(__Port), accepted(std::chrono::steady_clock::now())
 		{
 			static_assert(std::is_integral_v<Type>, "Given Port is not integral");
 		}
-		explicit connection(std::unique_ptr<boost::asio::io_service>&& __ios, std::unique_ptr<boost::asio::ip::tcp::socket>&& __Socket, std::size_t __Port)
-			: ios(std::move(__ios)), socket(std::move(__Socket)), port(std::move(__Port))
-		{ }
+		explicit connection(std::shared_ptr<context_pool::slot>&& __Slot, std::size_t __Port)
+			: slot(std::move(__Slot)), socket(std::in_place, slot->context), port(__Port), accepted(std::chrono::steady_clock::now())
+		{
+			slot->load.fetch_add(1, std::memory_order_relaxed);
+		}
+		explicit connection(std::shared_ptr<context_pool::slot>&& __Slot, entry const& Entry)
+			: slot(std::move(__Slot)), socket(std::in_place, slot->context), port(Entry.port),
+			  accepted(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(Entry.accepted))), Uring(Entry.uring),
+			  Prefetched(Entry.prefetched), PrefetchedSize(Entry.prefetched_size)
+		{
+			slot->load.fetch_add(1, std::memory_order_relaxed);
+		}
 		explicit connection(connection const&) = delete;
 		explicit connection(connection const&&) = delete;
-		~connection(void) = default;
+		~connection(void)
+		{
+			buffer::recycle(Prefetched);
+			socket.reset();
+			if (slot != nullptr)
+				slot->load.fetch_sub(1, std::memory_order_relaxed);
+			if (Fair != nullptr)
+				Fair->release(Ticket);
+		}
+
+		static void* operator new(const std::size_t Size);
+
+		static void operator delete(void* Pointer, const std::size_t Size);
+
+		boost::asio::ip::tcp::socket::executor_type get_executor(void)
+		{
+			return socket->get_executor();
+		}
+
+		boost::asio::io_context& get_context(void)
+		{
+			return slot->context;
+		}
+
+		/*
+		*	Waits for data and reads what is available into a pooled buffer, buffer is empty and Error is set on EOF.
+		*	Bytes which listener has prefetched are returned by the first read()
+		*/
+		buffer read(boost::system::error_code& Error);
+
+		/*
+		*	Same as read(), but appends to Into after its size, returns count of bytes which are read.
+		*	Prefetched bytes which do not fit stay for the next read
+		*/
+		std::size_t read(buffer& Into, boost::system::error_code& Error);
+
+		/*
+		*	Bytes which listener has read before dispatch(see listener::set_prefetch()), they are not in the socket
+		*	anymore. Empty after the first read()
+		*/
+		std::string_view prefetched(void) const
+		{
+			return std::string_view(Prefetched, Prefetched == nullptr ? 0 : PrefetchedSize);
+		}
+
+		/*
+		*	Writes all Parts one after another by writev(), they are not joined into one string
+		*/
+		std::size_t write(std::initializer_list<std::string_view> Parts, boost::system::error_code& Error);
+
+		std::size_t write(std::span<const std::string_view> Parts, boost::system::error_code& Error);
+
+		/*
+		*	Sends Count bytes of File from Offset by sendfile(), the whole file by default
+		*/
+		std::size_t sendfile(file const& File, boost::system::error_code& Error);
+
+		std::size_t sendfile(file const& File, const std::size_t Offset, const std::size_t Count, boost::system::error_code& Error);
+
+		/*
+		*	Sends Data with MSG_ZEROCOPY and returns after kernel has released Data, so it must live only until return.
+		*	Data which is smaller than ZeroCopyThreshold is copied by usual send(), it is cheaper
+		*/
+		std::size_t send_zerocopy(const std::string_view Data, boost::system::error_code& Error);
+
+		/*
+		*	Builds connection from the entry on io_context of Contexts.
+		*	Returns nullptr and closes descriptor if socket can not be registered
+		*/
+		static std::unique_ptr<connection> materialize(entry const& Entry, context_pool& Contexts);
+
+		/*
+		*	Closes descriptor of entry which is not going to be materialized
+		*/
+		static void discard(entry const& Entry);
+
+		private:
+			bool ZeroCopy = false;
+			std::uint32_t ZeroCopySent = 0;
+			bool Uring = false;
+			char* Prefetched = nullptr;
+			std::uint32_t PrefetchedSize = 0;
+			std::weak_ptr<parking> Parking;
+			std::shared_ptr<fair_queue> Fair;
+			fair_queue::ticket Ticket;
+
+			friend class server;
+
+			friend class queue;
+
+			friend void park(std::unique_ptr<connection> Connection);
+
+			std::size_t send_all(const std::string_view Data, const int Flags, boost::system::error_code& Error);
 	};
 
 
 	/*
-	*                    *-------------------------*
-	*   pull_one()  <->  |    Connections Order    |  <->  Background thread listener
-	*                    *-------------------------*
+	*	Settings of net::listener which acceptor threads read on every wake-up. They are published together as one
+	*	immutable snapshot(see listener::get_config()), a change copies it and swaps the pointer, so acceptor threads
+	*	never wait for a setter and always see a consistent set of values
+	*/
+	struct listener_config final
+	{
+		std::size_t port = 80;
+		std::size_t limit = 0;
+		std::size_t accept_batch = 64;
+		rejection_policy rejection;
+		backend kind = backend::epoll;
+		std::chrono::nanoseconds prefetch = std::chrono::nanoseconds(0);
+	};
+
+	/*
+	*                    *-------------------------*  <->  acceptor thread 1  \
+	*   pull_one()  <->  |    Connections Order    |  <->  acceptor thread 2   >--  Port
+	*                    *-------------------------*  <->  acceptor thread N  /
 	*
 	*	Listener is listening given port. By deafult this port is 80(HTTP).
+	*
+	*	Every acceptor thread owns one listening socket which is bound once and lives as long as the thread.
+	*	By default there is one acceptor thread. You can run more of them by set_acceptors() and get count by get_acceptors().
+	*	All sockets are opened with SO_REUSEPORT, so the kernel spreads incoming connections across acceptor threads.
+	*	On platforms without SO_REUSEPORT the count of acceptor threads is always 1.
+	*
+	*	Accepted sockets are bound to io_contexts of context_pool::shared(), see net::context_pool.
 	* 
 	*	You can change port in runtime by set_port() and get it by get_port().
+	*	set_port() binds the new port for every acceptor thread before it is published and throws if it can not,
+	*	then every thread accepts what is left in the backlog of the old socket and only then closes it,
+	*	so there is no moment without a listening socket.
 	* 
 	*	You can change a limit of order by set_limit() and get it by get_limit().
+	*	Setters do not pause accepting: port, limit, batch, rejection, backend and prefetch are one
+	*	listener_config snapshot which is swapped atomically, see get_config() and set_config().
+	*	Order is lock-free net::ring of plain entries(see net::entry) sized from the limit, acceptor threads and pull_one() never take a mutex.
+	*	net::connection is built only when it is pulled.
 	* 
 	*	You can get a size of current queue of connections by size().
 	* 
+	*	Acceptor thread sleeps in epoll_wait() until its socket is readable, then accepts without blocking until EAGAIN,
+	*	but not more than get_accept_batch() connections, and publishes them to the order at once - one wakeup of
+	*	the consumer per batch. You can change size of batch by set_accept_batch(). By default it is 64.
+	*	With set_backend(backend::io_uring) acceptor thread keeps multishot accept armed instead and publishes
+	*	every batch of completions, see net::backend.
+	* 
+	*	Clients over the limit are rejected by net::rejector on its own thread, acceptor thread only pushes them there.
+	*	You can choose how they are rejected by set_rejection(), by default they get ErrorMessage.
+	*	With rejection::backlog acceptor threads stop accepting while the order is full and
+	*	the first pull_one() after that wakes them up.
+	* 
+	*	Rate of new clients is limited by set_rate(Rate, Burst), and by the bucket of the queue for its listeners.
+	*	Buckets are taken for the whole accepted batch before it is published, so clients over the rate
+	*	are rejected by the same policy(reason::rate) while they are plain entries - no connection is built for them.
+	*	With rejection::backlog they are reset, they have been accepted already.
+	* 
+	*	snapshot() returns counters of accepted and rejected clients, see net::port_metrics.
+	* 
 	*	You can enable listener by enable() and disable it by disable().
-	*	Note that disable() waiting for last connection in current thread and then disabling listener.
+	*	Note that disabled listener keeps its sockets bound, new clients are waiting in the kernel backlog until enable().
+	* 
+	*	Constructor returns when the first acceptor thread listens, it sleeps on a notifier until then.
+	*	If the port can not be bound, constructor throws the error of bind.
 	* 
-	*	Distructor calls disable() and waiting for last connection.
+	*	Distructor wakes up acceptor threads and does not wait for any client: they are in epoll_wait() or
+	*	io_uring on their socket and wake-up eventfd, not in a blocking accept(), so it returns at once.
 	* 
 	*	Instances of this object are thread-safety.
 	*/
 	class listener final
 	{
-		bool Sleep = false;
-		std::thread Listener;
-		std::mutex ClientsMutex;
-		std::mutex EnabledMutex;
+		std::mutex SleepMutex;
 		std::mutex ThreadSafety;
+		std::mutex AcceptorsMutex;
+		std::atomic<bool> Sleep;
 		std::atomic<bool> Enabled;
-		std::atomic<bool> IsLocked;
-		std::atomic<std::size_t> Port;
-		std::atomic<std::size_t> Limit;
+		std::atomic<std::shared_ptr<const listener_config>> Config;
 		std::atomic<bool> IsConstructed;
-		std::queue<std::unique_ptr<connection>> Clients;
+		/*
+		*	Bound is listening socket of BoundPort which set_port() has bound for the thread, it is taken
+		*	on the next wake-up
+		*/
+		struct acceptor final
+		{
+			int Wake = -1;
+			int Listening = -1;
+			int Bound = -1;
+			std::size_t BoundPort = 0;
+			bool Retired = true;
+			std::thread Thread;
+		};
+
+		notifier Arrived;
+		notifier Started;
+		std::exception_ptr Failure;
+		std::atomic<notifier*> Observer;
+		token_bucket Bucket;
+		std::atomic<token_bucket*> Shared;
+		std::atomic<rejector*> Routed;
+		std::vector<std::unique_ptr<acceptor>> Acceptors;
+		std::shared_ptr<context_pool> Contexts;
+		std::atomic<bool> Backlogged;
+		std::shared_ptr<rejector> Rejector;
+		port_counters Counters;
+		std::atomic<std::size_t> AcceptorsCount;
+		std::condition_variable SleepCondition;
+		std::vector<int> Inherited;
+		ring<entry> Clients;
+
+		friend class queue;
 
 		public:
-			listener(void) : IsLocked(false),
-                    IsConstructed(false),
+			listener(void) : Sleep(false),
 					Enabled(true),
-					Port(80),
-					Limit(0)
+					Config(configure(80, 0)),
+					IsConstructed(false),
+					Observer(nullptr),
+					Shared(nullptr),
+					Routed(nullptr),
+					Contexts(context_pool::shared()),
+					Backlogged(false),
+					Rejector(rejector::shared()),
+					AcceptorsCount(0)
 			{
-				launch();
+				set_acceptors(1);
 				whileIsNotConstructed();
 			}
 
 			template<typename Type>
-			explicit listener(const Type Port) : Port(static_cast<std::size_t>(Port)),
-				             IsConstructed(false),
-							 IsLocked(false),
-							 Enabled(true),
-							 Limit(0)
+			explicit listener(const Type Port) : Sleep(false),
+				             Enabled(true),
+							 Config(configure(static_cast<std::size_t>(Port), 0)),
+							 IsConstructed(false),
+							 Observer(nullptr),
+							 Shared(nullptr),
+							 Routed(nullptr),
+							 Contexts(context_pool::shared()),
+							 Backlogged(false),
+							 Rejector(rejector::shared()),
+							 AcceptorsCount(0)
 			{
 				static_assert(std::is_integral_v<Type>, "Given Port is not integral");
 
-				launch();
+				set_acceptors(1);
 				whileIsNotConstructed();
 			}
 
 			template<typename Type1, typename Type2>
-			explicit listener(const Type1 Port, const Type2 Limit) : Limit(static_cast<std::size_t>(Limit)),
-				                        IsConstructed(false),
-										Port(static_cast<std::size_t>(Port)),
-										IsLocked(false),
-										Enabled(true)
+			explicit listener(const Type1 Port, const Type2 Limit) : Sleep(false),
+				                        Enabled(true),
+										Config(configure(static_cast<std::size_t>(Port), static_cast<std::size_t>(Limit))),
+										IsConstructed(false),
+										Observer(nullptr),
+										Shared(nullptr),
+										Routed(nullptr),
+										Contexts(context_pool::shared()),
+										Backlogged(false),
+										Rejector(rejector::shared()),
+										AcceptorsCount(0),
+										Clients(static_cast<std::size_t>(Limit))
 			{
 				static_assert(std::is_integral_v<Type1>, "Given Port is not integral");
 				static_assert(std::is_integral_v<Type2>, "Given Limit is not integral");
 
-				launch();
+				set_acceptors(1);
 				whileIsNotConstructed();
 			}
 
-			explicit listener(listener const&) = delete;
-			explicit listener(listener const&&) = delete;
-
-			~listener(void)
+			template<typename Type1, typename Type2, typename Type3>
+			explicit listener(const Type1 Port, const Type2 Limit, const Type3 Acceptors) : Sleep(false),
+				                        Enabled(true),
+										Config(configure(static_cast<std::size_t>(Port), static_cast<std::size_t>(Limit))),
+										IsConstructed(false),
+										Observer(nullptr),
+										Shared(nullptr),
+										Routed(nullptr),
+										Contexts(context_pool::shared()),
+										Backlogged(false),
+										Rejector(rejector::shared()),
+										AcceptorsCount(0),
+										Clients(static_cast<std::size_t>(Limit))
 			{
-				Enabled.store(false, std::memory_order_seq_cst);
+				static_assert(std::is_integral_v<Type1>, "Given Port is not integral");
+				static_assert(std::is_integral_v<Type2>, "Given Limit is not integral");
+				static_assert(std::is_integral_v<Type3>, "Given count of acceptors is not integral");
+
+				set_acceptors(Acceptors);
+				whileIsNotConstructed();
+			}
 
-				if (Sleep)
-					EnabledMutex.unlock();
+			/*
+			*	Listener on sockets which are listening already(see net::inherited), they are not bound again.
+			*	There is an acceptor thread for every one of them, acceptors over their count bind their own sockets
+			*/
+			template<typename Type1, typename Type2>
+			explicit listener(const Type1 Port, std::vector<int> Descriptors, const Type2 Acceptors) : Sleep(false),
+				                        Enabled(true),
+										Config(configure(static_cast<std::size_t>(Port), 0)),
+										IsConstructed(false),
+										Observer(nullptr),
+										Shared(nullptr),
+										Routed(nullptr),
+										Contexts(context_pool::shared()),
+										Backlogged(false),
+										Rejector(rejector::shared()),
+										AcceptorsCount(0),
+										Inherited(std::move(Descriptors))
+			{
+				static_assert(std::is_integral_v<Type1>, "Given Port is not integral");
+				static_assert(std::is_integral_v<Type2>, "Given count of acceptors is not integral");
 
-				if (Listener.joinable())
-					Listener.join();
-				else
-					throw std::runtime_error("Listener is not joinable");
+				set_acceptors(std::max<std::size_t>(static_cast<std::size_t>(Acceptors), Inherited.size()));
+				whileIsNotConstructed();
 			}
 
+			explicit listener(listener const&) = delete;
+			explicit listener(listener const&&) = delete;
+
+			~listener(void);
+
 			void enable(void);
 
 			void disable(void);
 
 			std::size_t get_port(void);
 
+			/*
+			*	New port is bound before it is published, the error of bind is thrown and the old port is kept then
+			*/
 			template<typename Type>
 			void set_port(const Type __Port)
 			{
 				static_assert(std::is_integral_v<Type>, "Given Port is not integral");
 
-				disable();
-				Port.store(__Port, std::memory_order_seq_cst);
-				enable();
+				rebind(static_cast<std::size_t>(__Port));
 			}
 
 			std::size_t get_limit(void);
 
+			/*
+			*	Clients which are over the new limit stay in the order, the next ones are checked against it
+			*/
 			template<typename Type>
-			void set_limit(const Type __Port)
+			void set_limit(const Type __Limit)
 			{
 				static_assert(std::is_integral_v<Type>, "Given Limit is not integral");
 
-				disable();
-				Limit.store(__Port, std::memory_order_seq_cst);
-				enable();
+				Clients.reserve(static_cast<std::size_t>(__Limit));
+				reconfigure([__Limit](listener_config& Next) -> void {
+					Next.limit = static_cast<std::size_t>(__Limit);
+				});
+			}
+
+			/*
+			*	Consistent snapshot of all settings, it is never changed - setters publish a new one
+			*/
+			std::shared_ptr<const listener_config> get_config(void) const;
+
+			/*
+			*	Replaces all settings at once, backend is checked as by set_backend() and port is bound as by set_port()
+			*/
+			void set_config(listener_config Next);
+
+			std::size_t get_acceptors(void) const;
+
+			std::size_t get_accept_batch(void) const;
+
+			/*
+			*	Not more than Rate new clients per second and Burst of them at once, Rate 0 disables the limit
+			*/
+			template<typename Type1, typename Type2>
+			void set_rate(const Type1 Rate, const Type2 Burst)
+			{
+				static_assert(std::is_integral_v<Type1>, "Given Rate is not integral");
+				static_assert(std::is_integral_v<Type2>, "Given Burst is not integral");
+
+				Bucket.set(static_cast<std::size_t>(Rate), static_cast<std::size_t>(Burst));
+			}
+
+			std::size_t get_rate(void) const;
+
+			std::size_t get_burst(void) const;
+
+			/*
+			*	What is done with clients over the limit, see net::rejection.
+			*	`backlog` with limit 0 is never triggered
+			*/
+			void set_rejection(const rejection Kind);
+
+			void set_rejection(rejection_policy Policy);
+
+			rejection get_rejection(void) const;
+
+			/*
+			*	backend::io_uring falls back to backend::epoll if it is not available
+			*/
+			void set_backend(const backend Kind);
+
+			backend get_backend(void) const;
+
+			/*
+			*	Prefetch mode: client gets into the order only when it has sent something, its first bytes are read
+			*	by acceptor thread into connection::prefetched(). Listening socket has TCP_DEFER_ACCEPT, clients which
+			*	are accepted without data anyway are watched by epoll of acceptor thread. Clients which are silent
+			*	for Timeout are closed and never take an executor. Timeout 0 disables it(default).
+			*	Prefetch mode accepts by epoll even with backend::io_uring
+			*/
+			template<typename Rep, typename Period>
+			void set_prefetch(const std::chrono::duration<Rep, Period> Timeout)
+			{
+				reconfigure([Timeout](listener_config& Next) -> void {
+					Next.prefetch = std::max(std::chrono::duration_cast<std::chrono::nanoseconds>(Timeout), std::chrono::nanoseconds(0));
+				});
+			}
+
+			std::chrono::nanoseconds get_prefetch(void) const;
+
+			/*
+			*	Accepted and rejected clients of this port since construction, depth and limit of the order
+			*/
+			port_metrics snapshot(void);
+
+			template<typename Type>
+			void set_accept_batch(const Type __Batch)
+			{
+				static_assert(std::is_integral_v<Type>, "Given size of batch is not integral");
+
+				reconfigure([__Batch](listener_config& Next) -> void {
+					Next.accept_batch = std::max<std::size_t>(static_cast<std::size_t>(__Batch), 1);
+				});
+			}
+
+			template<typename Type>
+			void set_acceptors(const Type __Acceptors)
+			{
+				static_assert(std::is_integral_v<Type>, "Given count of acceptors is not integral");
+
+				resize(static_cast<std::size_t>(__Acceptors));
 			}
 
 			std::size_t size(void);
@@ -176,14 +552,162 @@ namespace net
 			[[ nodiscard ]]
 			std::unique_ptr<connection> pull_one(void);
 
+			/*
+			*	Sleeps until there is a connection. Returns nullptr only if listener is destructing
+			*/
+			[[ nodiscard ]]
+			std::unique_ptr<connection> pull_one_wait(void);
+
+			/*
+			*	Sleeps until there is a connection or Timeout is expired. Returns nullptr on timeout
+			*/
+			template<typename Rep, typename Period>
+			[[ nodiscard ]]
+			std::unique_ptr<connection> pull_one_for(const std::chrono::duration<Rep, Period> Timeout)
+			{
+				const std::chrono::steady_clock::time_point Deadline = std::chrono::steady_clock::now() + Timeout;
+
+				while (true)
+				{
+					std::unique_ptr<connection> Result = pull_one();
+
+					if (Result != nullptr || !Enabled.load(std::memory_order_acquire))
+						return Result;
+					if (!Arrived.wait_until(Deadline, [this](void) -> bool { return ready(); }))
+						return nullptr;
+				}
+			}
+
+			/*
+			*	Takes up to Count connections which are in order now. Does not sleep
+			*/
+			[[ nodiscard ]]
+			std::vector<std::unique_ptr<connection>> pull_batch(const std::size_t Count);
+
+			/*
+			*	Same with pull_batch(), but sleeps up to Timeout if order is empty
+			*/
+			template<typename Rep, typename Period>
+			[[ nodiscard ]]
+			std::vector<std::unique_ptr<connection>> pull_batch_for(const std::size_t Count, const std::chrono::duration<Rep, Period> Timeout)
+			{
+				const std::chrono::steady_clock::time_point Deadline = std::chrono::steady_clock::now() + Timeout;
+
+				while (true)
+				{
+					std::vector<std::unique_ptr<connection>> Result = pull_batch(Count);
+
+					if (!Result.empty() || !Enabled.load(std::memory_order_acquire))
+						return Result;
+					if (!Arrived.wait_until(Deadline, [this](void) -> bool { return ready(); }))
+						return Result;
+				}
+			}
+
 			bool is_enabled(void) const;
 
 		private:
-			void launch(void);
+			bool ready(void);
+
+			void observe(notifier* __Observer);
+
+			/*
+			*	Bucket which is shared by all listeners of a queue, it is checked after the own one
+			*/
+			void share(token_bucket* __Shared);
+
+			/*
+			*	Rejector of the queue which has adopted the listener, the own one is used while it is nullptr
+			*/
+			void route(rejector* __Routed);
+
+			/*
+			*	Takes tokens for Batch and rejects clients which have got none, they are at the end of it
+			*/
+			void admit(std::vector<entry>& Batch);
+
+			void launch(const std::size_t Index);
+
+			void resize(std::size_t Count);
+
+			void wake(void);
+
+			void publish(std::vector<entry>& Batch);
+
+			std::vector<entry> pull_entries(const std::size_t Count);
+
+			void release(void);
+
+			std::shared_ptr<const rejection_policy> policy(void);
+
+			void bind(boost::asio::ip::tcp::acceptor& Acceptor, const std::size_t __Port);
+
+			void rebind(const std::size_t __Port);
+
+			/*
+			*	Binds Port for every running acceptor thread and hands the sockets to them. If one bind fails
+			*	nothing is handed and its error is thrown
+			*/
+			void bind_all(const std::size_t __Port);
+
+			/*
+			*	Duplicates of listening sockets of acceptor threads, caller closes them
+			*/
+			std::vector<int> descriptors(void);
+
+			static std::shared_ptr<const listener_config> configure(const std::size_t __Port, const std::size_t __Limit);
+
+			/*
+			*	Copies the current snapshot, lets Change edit the copy and publishes it. Concurrent setters retry
+			*	on their own copy, acceptor threads keep the snapshot they have loaded until their next wake-up
+			*/
+			template<typename Function>
+			void reconfigure(Function&& Change)
+			{
+				std::shared_ptr<const listener_config> Current = Config.load(std::memory_order_acquire);
+
+				while (true)
+				{
+					std::shared_ptr<listener_config> Next = std::make_shared<listener_config>(*Current);
+
+					Change(*Next);
+					if (Config.compare_exchange_weak(Current, std::shared_ptr<const listener_config>(std::move(Next)), std::memory_order_acq_rel, std::memory_order_acquire))
+						break;
+				}
+				wake();
+			}
+
+# ifdef NETORDERING_IO_URING
+			static constexpr unsigned UringEntries = 8;
 
+			/*
+			*	Accepts by io_uring until acceptor is woken up, false if multishot accept is not supported.
+			*	Ring is created by the first call and is reused by the next ones of the same thread
+			*/
+			bool accept_uring(std::optional<uring>& Ring, boost::asio::ip::tcp::acceptor& Acceptor, const int Wake, const std::size_t CachedPort);
+# endif
+
+			/*
+			*	Wakes up and joins acceptor threads
+			*/
+			void stop(void);
+
+			/*
+			*	Sleeps until the first acceptor thread is listening or has failed, rethrows its failure
+			*/
 			void whileIsNotConstructed(void);
 	};
 
+	/*
+	*	io_contexts and rejector of a queue, the process-wide context_pool::shared() and rejector::shared() for nullptr.
+	*	sharded_server gives every shard its own ones, so shards share nothing
+	*/
+	struct resources final
+	{
+		std::shared_ptr<context_pool> contexts = nullptr;
+		std::shared_ptr<rejector> rejections = nullptr;
+	};
+
 	/*
 	*                                    /  net::listener(Port1)
 	*                                   /  net::listener(Port2)
@@ -196,42 +720,87 @@ namespace net
 	*	methods are same with net::listener
 	* 
 	*	But also you have ability to shutdown specific port(-s) and enable them again
+	*	and to run several acceptor threads per port by set_acceptors()
+	*
+	*	Order is lock-free net::ring. Background thread moves connections from listeners
+	*	without holding the listeners mutex, it uses snapshot of listeners which is refreshed after add() and remove()
+	*
+	*	Ports are sharing the order by deficit round-robin: every pass a port gets weight * accept batch
+	*	connections of credit(set_weight(), 1 by default) and the first port of the pass is rotated.
+	*	Ports are also split to strict priority classes(set_priority(), 0 by default, higher is first) -
+	*	lower class is served only in a pass where all higher classes have nothing to move,
+	*	so a flood on a public port can not starve an internal control port with higher priority.
+	*
+	*	Clients of one port may also be ordered by their source: set_fairness(Buckets, Cap) keeps them in
+	*	net::fair_queue instead of the ring, so one peer which opens many connections gets one turn of pull_one()
+	*	like every other peer and not more than Cap of its connections are queued or alive at the same time.
 	*/
 	class queue
 	{
+		public:
+			struct share final
+			{
+				std::size_t Weight = 1;
+				std::size_t Priority = 0;
+			};
+
 		protected:
 			std::thread Updater;
 			std::mutex ThreadSafety;
 			std::atomic<bool> Status;
-			std::mutex QueueProtector;
 			std::atomic<bool> Enabled;
 			std::mutex ListenersProtector;
-			std::atomic<bool> IsConstructed;
 			std::atomic<std::size_t> LimitOrder;
-			std::vector<std::unique_ptr<listener>> Listeners;
-
-			std::queue<std::unique_ptr<connection>> Queue;
-
-			void whileIsNotConstructed(void);
+			notifier Ready;
+			notifier Applied;
+			notifier Arrivals;
+			std::atomic<std::size_t> AcceptBatch;
+			std::atomic<std::size_t> AcceptorsCount;
+			std::atomic<std::size_t> AppliedVersion;
+			std::atomic<std::size_t> ListenersVersion;
+			std::shared_ptr<context_pool> Contexts;
+			std::atomic<context_pool*> Pool;
+			std::vector<std::shared_ptr<context_pool>> Retired;
+			std::atomic<rejection> RejectionKind;
+			std::atomic<bool> Backlogged;
+			std::atomic<bool> Transferring;
+			std::atomic<std::shared_ptr<const rejection_policy>> Rejection;
+			std::shared_ptr<rejector> Rejector;
+			std::atomic<backend> Backend;
+			codel Codel;
+			token_bucket Bucket;
+			std::atomic<std::int64_t> MaxAge;
+			std::atomic<std::uint64_t> Expired;
+			std::atomic<std::uint64_t> Dropped;
+			std::vector<std::shared_ptr<listener>> Listeners;
+			std::unordered_map<std::size_t, share> Shares;
+			std::shared_ptr<fair_queue> Fair;
+
+			ring<entry> Queue;
 
 		public:
-			queue(void) : Enabled(true), Status(false), LimitOrder(0)
+			queue(void) : Status(false), Enabled(true), LimitOrder(0), AcceptBatch(64), AcceptorsCount(1), AppliedVersion(0), ListenersVersion(0), Contexts(context_pool::shared()), Pool(Contexts.get()),
+				RejectionKind(rejection::message), Backlogged(false), Transferring(false), Rejection(std::make_shared<rejection_policy>()), Rejector(rejector::shared()),
+				Backend(backend::epoll), MaxAge(0), Expired(0), Dropped(0), Fair(std::make_shared<fair_queue>())
 			{
 				launcher();
-
-				whileIsNotConstructed();
 			}
 
 			template<typename... Args>
-			queue(Args... args) : Enabled(true), Status(true), LimitOrder(0)
+			queue(Args... args) : Status(true), Enabled(true), LimitOrder(0), AcceptBatch(64), AcceptorsCount(1), AppliedVersion(0), ListenersVersion(0), Contexts(context_pool::shared()), Pool(Contexts.get()),
+				RejectionKind(rejection::message), Backlogged(false), Transferring(false), Rejection(std::make_shared<rejection_policy>()), Rejector(rejector::shared()),
+				Backend(backend::epoll), MaxAge(0), Expired(0), Dropped(0), Fair(std::make_shared<fair_queue>())
 			{
 				static_assert((std::is_integral_v<decltype(args)> && ...), "Given Port is not integral");
 
-				(Listeners.push_back(std::make_unique<listener>(args)), ...);
+				(Listeners.push_back(std::make_shared<listener>(args)), ...);
+				for (auto& Listener : Listeners)
+				{
+					Listener->observe(&Arrivals);
+					adopt(*Listener);
+				}
 
 				launcher();
-
-				whileIsNotConstructed();
 			}
 
 			explicit queue(queue const&) = delete;
@@ -240,11 +809,19 @@ namespace net
 			~queue(void)
 			{
 				Enabled.store(false, std::memory_order_seq_cst);
+				Arrivals.notify_all();
+				Applied.notify_all();
+				Ready.notify_all();
 
 				if (Updater.joinable())
 					Updater.join();
 				else
 					throw std::runtime_error("Updater is not joinable");
+
+				fair_queue::ticket Ticket;
+
+				while (std::optional<entry> Entry = pop(Ticket))
+					connection::discard(*Entry);
 			}
 
 			template<typename Type>
@@ -255,9 +832,9 @@ namespace net
 				std::lock_guard<std::mutex> ThreadSafetyLockGuard(ThreadSafety);
 
 				bool IsIncluded = false;
-				std::vector<std::unique_ptr<listener>>::iterator Iterator;
+				std::vector<std::shared_ptr<listener>>::iterator Iterator;
 				for (Iterator = Listeners.begin(); Iterator != Listeners.end(); Iterator += 1)
-					if (Iterator->get()->get_port() == Port)
+					if (Iterator->get()->get_port() == static_cast<std::size_t>(Port))
 					{
 						IsIncluded = true;
 						break;
@@ -267,7 +844,12 @@ namespace net
 				{
 					ListenersProtector.lock();
 
-					Listeners.push_back(std::make_unique<listener>(Port));
+					Listeners.push_back(std::make_shared<listener>(Port, 0, AcceptorsCount.load(std::memory_order_acquire)));
+					Listeners.back()->observe(&Arrivals);
+					Listeners.back()->set_accept_batch(AcceptBatch.load(std::memory_order_acquire));
+					adopt(*Listeners.back());
+					ListenersVersion.fetch_add(1, std::memory_order_release);
+					Arrivals.notify_all();
 					ListenersProtector.unlock();
 					update();
 				}
@@ -285,16 +867,27 @@ namespace net
 				static_assert(std::is_integral_v<Type>, "Given Port is not integral");
 
 				std::lock_guard<std::mutex> ThreadSafetyLockGuard(ThreadSafety);
+				std::vector<std::shared_ptr<listener>> Removed;
 				ListenersProtector.lock();
 
-				for (std::vector<std::unique_ptr<listener>>::iterator Iterator = Listeners.begin(); Iterator != Listeners.end();)
-					if (Iterator->get()->get_port() == Port)
+				for (std::vector<std::shared_ptr<listener>>::iterator Iterator = Listeners.begin(); Iterator != Listeners.end();)
+					if (Iterator->get()->get_port() == static_cast<std::size_t>(Port))
+					{
+						Removed.push_back(std::move(*Iterator));
 						Iterator = Listeners.erase(Iterator);
+					}
 					else
 						Iterator += 1;
+				const std::size_t Version = ListenersVersion.fetch_add(1, std::memory_order_acq_rel) + 1;
 
 				ListenersProtector.unlock();
 				update();
+
+				// Removed listeners are destroyed here, after background thread has dropped them from its snapshot
+				Arrivals.notify_all();
+				Applied.wait([&](void) -> bool {
+					return AppliedVersion.load(std::memory_order_acquire) >= Version || !Enabled.load(std::memory_order_acquire);
+				});
 			}
 
 			template<typename... Args>
@@ -303,6 +896,19 @@ namespace net
 				(remove(args), ...);
 			}
 
+			/*
+			*	Adds listeners on inherited sockets(see net::inherit()), ports which are listened already are skipped
+			*/
+			void inherit(inherited&& Sockets);
+
+			/*
+			*	Hot restart: waits up to Timeout on Unix socket Path for the new process which calls net::inherit(Path),
+			*	passes listening sockets of all listeners to it by SCM_RIGHTS and disables listeners of this queue.
+			*	New clients keep coming into the same sockets and the new process accepts them, this one serves
+			*	only what is in its order already. Returns count of passed sockets, 0 if nobody has come
+			*/
+			std::size_t hand_over(std::string const& Path, const std::chrono::milliseconds Timeout);
+
 			std::size_t size(void);
 
 			std::size_t get_limit_order(void);
@@ -313,11 +919,197 @@ namespace net
 				static_assert(std::is_integral_v<Type>, "Given Limit is not integral");
 
 				LimitOrder.store(__Limit, std::memory_order_relaxed);
+				Queue.reserve(static_cast<std::size_t>(__Limit));
+			}
+
+			std::size_t get_acceptors(void);
+
+			/*
+			*	Sets count of acceptor threads for every listener, also for listeners which will be added later
+			*/
+			template<typename Type>
+			void set_acceptors(const Type __Acceptors)
+			{
+				static_assert(std::is_integral_v<Type>, "Given count of acceptors is not integral");
+
+				std::lock_guard<std::mutex> ListenersProtectorLockGuard(ListenersProtector);
+
+				AcceptorsCount.store(__Acceptors, std::memory_order_release);
+				for (auto& Listener : Listeners)
+					Listener->set_acceptors(__Acceptors);
+			}
+
+			/*
+			*	Weight of Port in deficit round-robin, 0 is treated as 1.
+			*	Can be set before the port is added, it is kept after remove()
+			*/
+			template<typename Type1, typename Type2>
+			void set_weight(const Type1 Port, const Type2 Weight)
+			{
+				static_assert(std::is_integral_v<Type1>, "Given Port is not integral");
+				static_assert(std::is_integral_v<Type2>, "Given Weight is not integral");
+
+				std::lock_guard<std::mutex> ListenersProtectorLockGuard(ListenersProtector);
+
+				Shares[static_cast<std::size_t>(Port)].Weight = std::max<std::size_t>(static_cast<std::size_t>(Weight), 1);
+				ListenersVersion.fetch_add(1, std::memory_order_release);
+				Arrivals.notify_all();
+			}
+
+			template<typename Type>
+			std::size_t get_weight(const Type Port)
+			{
+				static_assert(std::is_integral_v<Type>, "Given Port is not integral");
+
+				return get_share(static_cast<std::size_t>(Port)).Weight;
+			}
+
+			/*
+			*	Strict priority class of Port, higher class is served first
+			*/
+			template<typename Type1, typename Type2>
+			void set_priority(const Type1 Port, const Type2 Priority)
+			{
+				static_assert(std::is_integral_v<Type1>, "Given Port is not integral");
+				static_assert(std::is_integral_v<Type2>, "Given Priority is not integral");
+
+				std::lock_guard<std::mutex> ListenersProtectorLockGuard(ListenersProtector);
+
+				Shares[static_cast<std::size_t>(Port)].Priority = static_cast<std::size_t>(Priority);
+				ListenersVersion.fetch_add(1, std::memory_order_release);
+				Arrivals.notify_all();
+			}
+
+			template<typename Type>
+			std::size_t get_priority(const Type Port)
+			{
+				static_assert(std::is_integral_v<Type>, "Given Port is not integral");
+
+				return get_share(static_cast<std::size_t>(Port)).Priority;
+			}
+
+			/*
+			*	CoDel target of time in the order and its interval, Target 0 disables it
+			*/
+			template<typename Rep1, typename Period1, typename Rep2 = std::chrono::milliseconds::rep, typename Period2 = std::chrono::milliseconds::period>
+			void set_target(const std::chrono::duration<Rep1, Period1> Target,
+				const std::chrono::duration<Rep2, Period2> Interval = std::chrono::milliseconds(100))
+			{
+				Codel.set(std::chrono::duration_cast<std::chrono::nanoseconds>(Target).count(),
+					std::max<std::int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Interval).count(), 1));
+			}
+
+			std::chrono::nanoseconds get_target(void) const;
+
+			/*
+			*	Clients older than Age are never pulled, Age 0 disables it
+			*/
+			template<typename Rep, typename Period>
+			void set_max_age(const std::chrono::duration<Rep, Period> Age)
+			{
+				MaxAge.store(std::chrono::duration_cast<std::chrono::nanoseconds>(Age).count(), std::memory_order_relaxed);
+			}
+
+			std::chrono::nanoseconds get_max_age(void) const;
+
+			/*
+			*	io_contexts for connections which are pulled from now, context_pool::shared() by default.
+			*	Previous pool is kept alive until queue is destructed
+			*/
+			void set_contexts(std::shared_ptr<context_pool> __Contexts);
+
+			std::shared_ptr<context_pool> get_contexts(void);
+
+			std::size_t get_accept_batch(void);
+
+			/*
+			*	What is done with clients over LimitOrder, same with net::listener.
+			*	With rejection::backlog listeners of the queue keep not more than accept batch of clients,
+			*	the rest is waiting in the kernel backlog
+			*/
+			void set_rejection(const rejection Kind);
+
+			void set_rejection(rejection_policy Policy);
+
+			rejection get_rejection(void) const;
+
+			/*
+			*	Backend of every listener, see net::backend
+			*/
+			void set_backend(const backend Kind);
+
+			backend get_backend(void) const;
+
+			/*
+			*	Counters of every port and depth of the order, see net::metrics and net::prometheus()
+			*/
+			metrics snapshot(void);
+
+			/*
+			*	Sets size of accept batch for every listener(see net::listener) and count of connections
+			*	which are moved from one listener to the order at once(credit of a port with weight 1)
+			*/
+			template<typename Type>
+			void set_accept_batch(const Type __Batch)
+			{
+				static_assert(std::is_integral_v<Type>, "Given size of batch is not integral");
+
+				std::lock_guard<std::mutex> ListenersProtectorLockGuard(ListenersProtector);
+
+				AcceptBatch.store(std::max<std::size_t>(static_cast<std::size_t>(__Batch), 1), std::memory_order_release);
+				for (auto& Listener : Listeners)
+				{
+					Listener->set_accept_batch(__Batch);
+					adopt(*Listener);
+				}
 			}
 
 			[[ nodiscard ]]
 			std::unique_ptr<connection> pull_one(void);
 
+			/*
+			*	Blocking and timed versions of pull_one(), same with net::listener
+			*/
+			[[ nodiscard ]]
+			std::unique_ptr<connection> pull_one_wait(void);
+
+			template<typename Rep, typename Period>
+			[[ nodiscard ]]
+			std::unique_ptr<connection> pull_one_for(const std::chrono::duration<Rep, Period> Timeout)
+			{
+				const std::chrono::steady_clock::time_point Deadline = std::chrono::steady_clock::now() + Timeout;
+
+				while (true)
+				{
+					std::unique_ptr<connection> Result = pull_one();
+
+					if (Result != nullptr || !Enabled.load(std::memory_order_acquire))
+						return Result;
+					if (!Ready.wait_until(Deadline, [this](void) -> bool { return ready(); }))
+						return nullptr;
+				}
+			}
+
+			[[ nodiscard ]]
+			std::vector<std::unique_ptr<connection>> pull_batch(const std::size_t Count);
+
+			template<typename Rep, typename Period>
+			[[ nodiscard ]]
+			std::vector<std::unique_ptr<connection>> pull_batch_for(const std::size_t Count, const std::chrono::duration<Rep, Period> Timeout)
+			{
+				const std::chrono::steady_clock::time_point Deadline = std::chrono::steady_clock::now() + Timeout;
+
+				while (true)
+				{
+					std::vector<std::unique_ptr<connection>> Result = pull_batch(Count);
+
+					if (!Result.empty() || !Enabled.load(std::memory_order_acquire))
+						return Result;
+					if (!Ready.wait_until(Deadline, [this](void) -> bool { return ready(); }))
+						return Result;
+				}
+			}
+
 			void enable(void);
 
 			void disable(void);
@@ -329,8 +1121,8 @@ namespace net
 
 				ListenersProtector.lock();
 
-				for (std::vector<std::unique_ptr<listener>>::iterator Iterator = Listeners.begin(); Iterator != Listeners.end(); Iterator += 1)
-					if (Iterator->get()->get_port() == Port)
+				for (std::vector<std::shared_ptr<listener>>::iterator Iterator = Listeners.begin(); Iterator != Listeners.end(); Iterator += 1)
+					if (Iterator->get()->get_port() == static_cast<std::size_t>(Port))
 						Iterator->get()->enable();
 
 				ListenersProtector.unlock();
@@ -361,11 +1153,11 @@ namespace net
 				static_assert(std::is_integral_v<Type1>, "Given Port is not integral");
 				static_assert(std::is_integral_v<Type2>, "Given Limit is not integral");
 
-				std::lock_guard<std::mutex> ThreadSafetyLockGuard(ThreadSafety);
+				// Listener publishes the limit without pausing its acceptors, so only the list of listeners is locked
 				std::lock_guard<std::mutex> ListenersProtectorLockGuard(ListenersProtector);
 
 				for (decltype(Listeners)::iterator Iterator = Listeners.begin(); Iterator != Listeners.end(); Iterator += 1)
-					if (Iterator->get()->get_port() == Port)
+					if (Iterator->get()->get_port() == static_cast<std::size_t>(Port))
 					{
 						Iterator->get()->set_limit(Limit);
 					
@@ -373,6 +1165,70 @@ namespace net
 					}
 			}
 
+			/*
+			*	Rate of all ports together, it is checked in acceptor threads after the bucket of the port.
+			*	Clients over it are rejected by the rejection policy of the queue, see listener::set_rate()
+			*/
+			template<typename Type1, typename Type2>
+			void set_rate(const Type1 Rate, const Type2 Burst)
+			{
+				static_assert(std::is_integral_v<Type1>, "Given Rate is not integral");
+				static_assert(std::is_integral_v<Type2>, "Given Burst is not integral");
+
+				Bucket.set(static_cast<std::size_t>(Rate), static_cast<std::size_t>(Burst));
+			}
+
+			std::size_t get_rate(void) const;
+
+			std::size_t get_burst(void) const;
+
+			/*
+			*	Fair order of clients by their source(see net::fair_queue): Buckets sub-orders, Cap clients of one
+			*	bucket which are queued or alive(0 is unlimited). Clients over Cap are rejected like the ones over
+			*	LimitOrder. Buckets 0 returns to the plain order, it is so by default
+			*/
+			template<typename Type1, typename Type2>
+			void set_fairness(const Type1 Buckets, const Type2 Cap)
+			{
+				static_assert(std::is_integral_v<Type1>, "Given Buckets is not integral");
+				static_assert(std::is_integral_v<Type2>, "Given Cap is not integral");
+
+				Fair->configure(static_cast<std::size_t>(Buckets), static_cast<std::size_t>(Cap));
+			}
+
+			std::size_t get_fairness(void) const;
+
+			template<typename Type1, typename Type2, typename Type3>
+			void set_specific_rate(const Type1 Port, const Type2 Rate, const Type3 Burst)
+			{
+				static_assert(std::is_integral_v<Type1>, "Given Port is not integral");
+
+				std::lock_guard<std::mutex> ListenersProtectorLockGuard(ListenersProtector);
+
+				for (decltype(Listeners)::iterator Iterator = Listeners.begin(); Iterator != Listeners.end(); Iterator += 1)
+					if (Iterator->get()->get_port() == static_cast<std::size_t>(Port))
+					{
+						Iterator->get()->set_rate(Rate, Burst);
+
+						return;
+					}
+			}
+
+			/*
+			*	Prefetch mode of Port, see listener::set_prefetch()
+			*/
+			template<typename Type, typename Rep, typename Period>
+			void set_prefetch(const Type Port, const std::chrono::duration<Rep, Period> Timeout)
+			{
+				static_assert(std::is_integral_v<Type>, "Given Port is not integral");
+
+				std::lock_guard<std::mutex> ListenersProtectorLockGuard(ListenersProtector);
+
+				for (decltype(Listeners)::iterator Iterator = Listeners.begin(); Iterator != Listeners.end(); Iterator += 1)
+					if (Iterator->get()->get_port() == static_cast<std::size_t>(Port))
+						Iterator->get()->set_prefetch(Timeout);
+			}
+
 			template<typename Type>
 			std::size_t get_specific_limit(const Type Port)
 			{
@@ -382,7 +1238,7 @@ namespace net
 				std::lock_guard<std::mutex> ListenersProtectorLockGuard(ListenersProtector);
 
 				for (decltype(Listeners)::iterator Iterator = Listeners.begin(); Iterator != Listeners.end(); Iterator += 1)
-					if (Iterator->get()->get_port() == Port)
+					if (Iterator->get()->get_port() == static_cast<std::size_t>(Port))
 						return Iterator->get()->get_limit();
 
 				throw std::runtime_error("Object has not specified port");
@@ -397,17 +1253,98 @@ namespace net
 				std::lock_guard<std::mutex> ListenersProtectorLockGuard(ListenersProtector);
 
 				for(decltype(Listeners)::iterator Iterator = Listeners.begin(); Iterator != Listeners.end(); Iterator += 1)
-					if (Iterator->get()->get_port() == Port)
+					if (Iterator->get()->get_port() == static_cast<std::size_t>(Port))
 						return true;
 				return false;
 			}
 
+		protected:
+			bool ready(void);
+
+			/*
+			*	Replaces io_contexts and rejector of a queue which has no ports yet, so no client has used the previous ones
+			*/
+			void provide(resources Resources);
+
+			/*
+			*	Whether both the ring and the fair order are empty
+			*/
+			bool empty(void) const;
+
+			/*
+			*	Rejects clients which are in the order and in listeners by the rejection policy, returns their count
+			*/
+			std::size_t reject_pending(void);
+
+			/*
+			*	Whether a client which waits since Since(nanoseconds of steady_clock) is over max age or is dropped
+			*	by CoDel, counts it in expired or dropped then. Empty tells CoDel that nothing is waiting after it
+			*/
+			bool late(const std::int64_t Since, const bool Empty);
+
+			/*
+			*	Rejects Entry by the rejection policy if it is late(see late()), true then
+			*/
+			bool stale(entry const& Entry);
+
+			/*
+			*	Next client of the order as a plain entry for a peer which builds the connection on its own
+			*	io_contexts(see server::steal()). It leaves the fair order at once
+			*/
+			std::optional<entry> pull_entry(void);
+
 		private:
+			share get_share(const std::size_t Port);
+
+			/*
+			*	Copies the rejection policy, lets Change edit the copy and publishes it, concurrent setters retry
+			*	on their own copy. RejectionKind and listeners are updated under the listeners mutex from the policy
+			*	which is published last, so they never keep the kind of a lost update
+			*/
+			template<typename Function>
+			void repolicy(Function&& Change)
+			{
+				std::shared_ptr<const rejection_policy> Current = Rejection.load(std::memory_order_acquire);
+
+				while (true)
+				{
+					std::shared_ptr<rejection_policy> Next = std::make_shared<rejection_policy>(*Current);
+
+					Change(*Next);
+					if (Rejection.compare_exchange_weak(Current, std::shared_ptr<const rejection_policy>(std::move(Next)), std::memory_order_acq_rel, std::memory_order_acquire))
+						break;
+				}
+
+				std::lock_guard<std::mutex> ListenersProtectorLockGuard(ListenersProtector);
+
+				RejectionKind.store(Rejection.load(std::memory_order_acquire)->kind, std::memory_order_release);
+				for (auto& Listener : Listeners)
+					adopt(*Listener);
+			}
+
+			void adopt(listener& Listener);
+
+			/*
+			*	Next client of the fair order if there is one, of the ring otherwise
+			*/
+			std::optional<entry> pop(fair_queue::ticket& Ticket);
+
+			void release(void);
+
 			void launcher(void);
 
 			void update(void);
 	};
 
+# ifdef BOOST_ASIO_HAS_CO_AWAIT
+	/*
+	*	Callback which is a coroutine: boost::asio::awaitable<void>(std::unique_ptr<net::connection>)
+	*/
+	template<typename Callback>
+	concept coroutine_handler = std::is_invocable_v<Callback&, std::unique_ptr<connection>>
+		&& std::is_same_v<std::invoke_result_t<Callback&, std::unique_ptr<connection>>, boost::asio::awaitable<void>>;
+# endif
+
 	/*
 	*                                   /  <->  pull_one() <-> net::listener(Port1)
 	*                                  /  <->  pull_one() <-> net::listener(Port2)
@@ -420,31 +1357,178 @@ namespace net
 	*	Constructor waiting for your callback function. It could be any callable object type of void(std::unique_ptr<net::connection>)
 	*	Then in special race order server will call your callback function for any accepted client from any port
 	* 
-	*	But, server creating a new thread for each callback invoke - for each new net::connection
-	*	You can set up the limit of this threads by set_limit_executor() or check it by get_limit_executor()
-	*	By default it is std::thread::hardware_concurency()
+	*	Callback is called by a fixed pool of executor threads(see net::executor), they are created once with server.
+	*	Connection is taken from the order only when some executor is free, the others are waiting for their order.
+	*	You can set up the count of executors by set_limit_executor() or check it by get_limit_executor()
+	*	Pool is resized in runtime. By default and for 0 it is std::thread::hardware_concurency()
+	* 
+	*	Callback also could be a coroutine - boost::asio::awaitable<void>(std::unique_ptr<net::connection>):
+	* 
+	*		net::server Server([](std::unique_ptr<net::connection> Connection) -> boost::asio::awaitable<void> {
+	*			char Data[1024];
+	*			std::size_t Size = co_await Connection->socket->async_read_some(boost::asio::buffer(Data), boost::asio::use_awaitable);
+	*			co_await boost::asio::async_write(*Connection->socket, boost::asio::buffer(Data, Size), boost::asio::use_awaitable);
+	*		}, 80);
+	* 
+	*	Then there are no executor threads, coroutine is co_spawn'ed on io_context of the connection(see net::context_pool)
+	*	and waiting client costs no thread. In this mode set_limit_executor() limits count of coroutines which are
+	*	alive at the same time. By default and for 0 it is unlimited.
+	* 
+	*	Keep-alive: callback which has answered may give the connection back by net::park(std::move(Connection)).
+	*	It waits for the next request in the parking set(see net::parking) without a thread, and the callback
+	*	is called with it again when it is readable. Idle ones are closed after set_idle_timeout(), 60 seconds by default.
+	* 
+	*		net::server Server([](std::unique_ptr<net::connection> Connection) -> void {
+	*			boost::system::error_code Error;
+	*			net::buffer Request = Connection->read(Error);
+	*			Connection->write({ "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nOK" }, Error);
+	*			if (!Error)
+	*				net::park(std::move(Connection));
+	*		}, 80);
+	* 
+	*	Hot restart: the old process calls hand_over(Path, Timeout) and the new one is built on its sockets,
+	*	nothing is rebound and no client is refused between them:
+	* 
+	*		net::server Server(Callback, net::inherit(Path), 80, 443);
+	* 
+	*	Shutdown: drain(Deadline) stops accepting and waits for the order and callbacks up to Deadline.
+	*	Destructor waits for callbacks which are running, so drain() first bounds the time of shutdown:
+	* 
+	*		Server.hand_over(Path, std::chrono::seconds(10));
+	*		Server.drain(std::chrono::seconds(30));
 	*/
 	class server final : public queue
 	{
+# ifdef BOOST_ASIO_HAS_CO_AWAIT
+		/*
+		*	Parked connection which has become readable, it waits for an executor like a new client
+		*/
+		struct resumed final
+		{
+			std::unique_ptr<connection> Connection = nullptr;
+			std::int64_t Since = 0;
+		};
+
+		struct coroutines final
+		{
+			notifier Done;
+			std::atomic<std::size_t> Active;
+			std::function<boost::asio::awaitable<void>(std::unique_ptr<connection>)> Handler;
+
+			template<typename Callback>
+			explicit coroutines(Callback CallBack) : Active(0), Handler(std::move(CallBack))
+			{ }
+		};
+
+		std::shared_ptr<coroutines> Coroutines;
+# endif
+		std::shared_ptr<histogram> Waits;
+		std::shared_ptr<histogram> Durations;
 		std::thread Updater;
 		std::atomic<std::size_t> LimitExecutor;
-		std::vector<std::pair<std::thread, std::future<void>>> Executors;
+		static constexpr std::chrono::milliseconds StealInterval = std::chrono::milliseconds(1);
+
+		static constexpr std::chrono::milliseconds DrainInterval = std::chrono::milliseconds(10);
+
+		std::atomic<bool> Stealing;
+		std::atomic<bool> Holding;
+		std::mutex PeersMutex;
+		std::size_t NextPeer;
+		std::vector<std::weak_ptr<server>> Peers;
+		std::unique_ptr<executor> Executors;
+		ring<resumed> Resumed;
+		std::shared_ptr<parking> Parking;
+
+		friend class sharded_server;
 
 		public:
 			template<typename Callback>
-			server(const Callback CallBack) :queue(), LimitExecutor(std::thread::hardware_concurrency())
+# ifdef BOOST_ASIO_HAS_CO_AWAIT
+				requires (!coroutine_handler<Callback>)
+# endif
+			server(const Callback CallBack) :queue(),
+				Waits(std::make_shared<histogram>()),
+				Durations(std::make_shared<histogram>()),
+				LimitExecutor(std::thread::hardware_concurrency()),
+				Stealing(false),
+				Holding(false),
+				NextPeer(0),
+				Executors(std::make_unique<executor>(handler(CallBack, Durations), std::thread::hardware_concurrency())),
+				Parking(make_parking())
 			{
-				launch(CallBack);
+				launch();
+			}
 
-				whileIsNotConstructed();
+			template<typename Callback, typename... Args>
+# ifdef BOOST_ASIO_HAS_CO_AWAIT
+				requires (!coroutine_handler<Callback>)
+# endif
+			server(const Callback CallBack, Args... args) :queue(args...),
+				Waits(std::make_shared<histogram>()),
+				Durations(std::make_shared<histogram>()),
+				LimitExecutor(std::thread::hardware_concurrency()),
+				Stealing(false),
+				Holding(false),
+				NextPeer(0),
+				Executors(std::make_unique<executor>(handler(CallBack, Durations), std::thread::hardware_concurrency())),
+				Parking(make_parking())
+			{
+				launch();
+			}
+
+# ifdef BOOST_ASIO_HAS_CO_AWAIT
+			template<coroutine_handler Callback>
+			server(const Callback CallBack) :queue(),
+				Coroutines(std::make_shared<coroutines>(CallBack)),
+				Waits(std::make_shared<histogram>()),
+				Durations(std::make_shared<histogram>()),
+				LimitExecutor(0),
+				Stealing(false),
+				Holding(false),
+				NextPeer(0),
+				Parking(make_parking())
+			{
+				launch();
 			}
 
+			template<coroutine_handler Callback, typename... Args>
+			server(const Callback CallBack, Args... args) :queue(args...),
+				Coroutines(std::make_shared<coroutines>(CallBack)),
+				Waits(std::make_shared<histogram>()),
+				Durations(std::make_shared<histogram>()),
+				LimitExecutor(0),
+				Stealing(false),
+				Holding(false),
+				NextPeer(0),
+				Parking(make_parking())
+			{
+				launch();
+			}
+# endif
+
+			/*
+			*	Takes listening sockets of the previous process(see net::inherit(), net::inherit_systemd()),
+			*	ports of Args which are not among them are bound as usual
+			*/
 			template<typename Callback, typename... Args>
-			server(const Callback CallBack, Args... args) :queue(args...), LimitExecutor(std::thread::hardware_concurrency())
+			server(const Callback CallBack, inherited&& Sockets, Args... args) : server(CallBack)
 			{
-				launch(CallBack);
+				static_assert((std::is_integral_v<decltype(args)> && ...), "Given Port is not integral");
 
-				whileIsNotConstructed();
+				inherit(std::move(Sockets));
+				(add(args), ...);
+			}
+
+			/*
+			*	Server on its own io_contexts and rejector(see net::resources), ports of Args are added after them
+			*/
+			template<typename Callback, typename... Args>
+			server(const Callback CallBack, resources Resources, Args... args) : server(CallBack)
+			{
+				static_assert((std::is_integral_v<decltype(args)> && ...), "Given Port is not integral");
+
+				provide(std::move(Resources));
+				(add(args), ...);
 			}
 
 			explicit server(server const&) = delete;
@@ -453,11 +1537,18 @@ namespace net
 			~server(void)
 			{
 				Enabled.store(false, std::memory_order_release);
+				Ready.notify_all();
+				interrupt();
 
 				if (Updater.joinable())
 					Updater.join();
 				else
 					throw std::runtime_error("Updater is not joinable");
+
+				// Handler which is still running may park its connection, parking is closed before workers
+				// are joined, so nothing reaches Resumed or Ready after the members are destroyed
+				Parking->close();
+				Executors.reset();
 			}
 
 			template<typename Type>
@@ -466,6 +1557,9 @@ namespace net
 				static_assert(std::is_integral_v<Type>, "Given Limit is not integral");
 
 				LimitExecutor.store(Limit, std::memory_order_relaxed);
+				if (Executors != nullptr)
+					Executors->resize(static_cast<std::size_t>(Limit));
+				interrupt();
 			}
 
 			std::size_t get_limit_executor(void) const;
@@ -474,43 +1568,104 @@ namespace net
 
 			std::vector<std::size_t> active_listeners(void);
 
+			/*
+			*	Keeps Connection until it is readable and calls the handler with it again, same with net::park().
+			*	Readable connection waits for an executor before new clients, max age and CoDel apply to that wait
+			*/
+			void park(std::unique_ptr<connection> Connection);
+
+			/*
+			*	Parked connections which are idle for Timeout are closed
+			*/
+			template<typename Rep, typename Period>
+			void set_idle_timeout(const std::chrono::duration<Rep, Period> Timeout)
+			{
+				Parking->set_timeout(std::chrono::duration_cast<std::chrono::nanoseconds>(Timeout).count());
+			}
+
+			std::chrono::nanoseconds get_idle_timeout(void) const;
+
+			/*
+			*	Graceful shutdown: listeners stop accepting, parked connections are closed and clients which are
+			*	in the order or are resumed are still given to the callback. Returns true if the order is empty and every
+			*	callback has returned before Deadline. Otherwise clients which are left in the order are rejected
+			*	by the rejection policy at Deadline, resumed connections are closed and false is returned, running callbacks
+			*	are not interrupted.
+			*
+			*	Connections are not parked after it, the callback sees them closed instead
+			*/
+			bool drain(const std::chrono::steady_clock::time_point Deadline);
+
+			template<typename Rep, typename Period>
+			bool drain(const std::chrono::duration<Rep, Period> Timeout)
+			{
+				return drain(std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(Timeout));
+			}
+
+			/*
+			*	Same with queue::snapshot(), and also time in the order before dispatch and duration of the callback
+			*/
+			metrics snapshot(void);
+
 		private:
 			template<typename Callback>
-			void launch(const Callback CallBack)
+			static std::function<void(std::unique_ptr<connection>)> handler(const Callback CallBack, std::shared_ptr<histogram> const& Durations)
 			{
 				static_assert(std::is_invocable_v<Callback, std::unique_ptr<connection>>, "Callable object must have unique_ptr<connection> as entry type and has operator()");
-			
-				Updater = std::thread([&](void) -> void {
-					while (Enabled.load(std::memory_order_acquire))
+
+				return [CallBack = Callback(CallBack), Durations](std::unique_ptr<connection> Connection) mutable -> void {
+					const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+					try
 					{
-						for(decltype(Executors)::iterator Iterator = Executors.begin(); Iterator != Executors.end();)
-						{
-							if (Iterator->second.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready)
-							{
-								if (Iterator->first.joinable())
-									Iterator->first.join();
-								else
-									throw std::runtime_error("Listener is not joinable");
-
-								Iterator = Executors.erase(Iterator);
-							}
-							else
-								Iterator += 1;
-						}
-						const std::size_t CachedLimit = LimitExecutor.load(std::memory_order_acquire);
-
-						if (CachedLimit == 0 || Executors.size() < CachedLimit)
-						{
-							std::unique_ptr<connection> Connection = pull_one();
-							if (Connection == nullptr)
-								continue;
-
-							std::packaged_task<void(std::unique_ptr<connection>)> Task{CallBack};
-							std::future<void> Future = Task.get_future();
-							Executors.push_back(std::make_pair(std::thread{ std::move(Task), std::move(Connection) }, std::move(Future)));
-						}
+						CallBack(std::move(Connection));
 					}
-				});
+					catch (...)
+					{
+						Durations->record(static_cast<std::uint64_t>((std::chrono::steady_clock::now() - Start).count()));
+						throw;
+					}
+					Durations->record(static_cast<std::uint64_t>((std::chrono::steady_clock::now() - Start).count()));
+				};
 			}
+
+			void launch(void);
+
+			std::shared_ptr<parking> make_parking(void);
+
+			/*
+			*	Other servers which this one can take connections from while its own order is empty(see net::sharded_server)
+			*/
+			void set_peers(std::vector<std::weak_ptr<server>> __Peers);
+
+			void set_stealing(const bool __Stealing);
+
+			std::unique_ptr<connection> steal(void);
+
+			std::size_t available(void) const;
+
+			void wait_available(void);
+
+			void submit(std::unique_ptr<connection> Connection);
+
+			/*
+			*	Next resumed connection which is not late, late ones are closed
+			*/
+			std::unique_ptr<connection> resume(void);
+
+			/*
+			*	Gives connection to a worker or spawns the coroutine
+			*/
+			void dispatch(std::unique_ptr<connection> Connection);
+
+			void interrupt(void);
+
+			/*
+			*	No client is in listeners, in the order, on the way to executors or in a callback
+			*/
+			bool idle(void);
 	};
-}
\ No newline at end of file
+}
+
+# include <netordering/sharded.hpp>
+# include <netordering/http.hpp>
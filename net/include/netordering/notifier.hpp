@@ -0,0 +1,106 @@
+# pragma once
+
+# include <condition_variable>
+# include <cstddef>
+# include <atomic>
+# include <chrono>
+# include <mutex>
+
+namespace net
+{
+	/*
+	*	producer  ->  notify_one() / notify_all()  ->  *----------*  ->  wait() / wait_until()  ->  consumer
+	*	                                               | notifier |
+	*	                                               *----------*
+	*
+	*	Wakeup primitive for threads which are waiting for new connections instead of spinning.
+	*
+	*	notify_one() and notify_all() cost one atomic increment when nobody is waiting,
+	*	the mutex is taken only if there is a sleeping consumer.
+	*
+	*	epoch() is incremented by every notify, so consumer can remember it before checking
+	*	its sources and then wait until it changes without losing a wakeup between check and sleep.
+	*/
+	class notifier final
+	{
+		std::mutex Mutex;
+		std::atomic<std::size_t> Epoch;
+		std::atomic<std::size_t> Waiters;
+		std::condition_variable Condition;
+
+		public:
+			notifier(void) : Epoch(0), Waiters(0)
+			{ }
+
+			explicit notifier(notifier const&) = delete;
+			explicit notifier(notifier const&&) = delete;
+
+			std::size_t epoch(void) const
+			{
+				return Epoch.load(std::memory_order_acquire);
+			}
+
+			void notify_one(void)
+			{
+				Epoch.fetch_add(1, std::memory_order_seq_cst);
+
+				if (Waiters.load(std::memory_order_seq_cst) != 0)
+				{
+					{
+						std::lock_guard<std::mutex> LockGuard(Mutex);
+					}
+					Condition.notify_one();
+				}
+			}
+
+			void notify_all(void)
+			{
+				Epoch.fetch_add(1, std::memory_order_seq_cst);
+
+				if (Waiters.load(std::memory_order_seq_cst) != 0)
+				{
+					{
+						std::lock_guard<std::mutex> LockGuard(Mutex);
+					}
+					Condition.notify_all();
+				}
+			}
+
+			template<typename Predicate>
+			void wait(Predicate Ready)
+			{
+				if (Ready())
+					return;
+
+				Waiters.fetch_add(1, std::memory_order_seq_cst);
+				{
+					std::unique_lock<std::mutex> Lock(Mutex);
+
+					Condition.wait(Lock, Ready);
+				}
+				Waiters.fetch_sub(1, std::memory_order_seq_cst);
+			}
+
+			/*
+			*	Returns result of Ready() - false means that deadline was reached
+			*/
+			template<typename Clock, typename Duration, typename Predicate>
+			bool wait_until(const std::chrono::time_point<Clock, Duration>& Deadline, Predicate Ready)
+			{
+				if (Ready())
+					return true;
+
+				bool Result = false;
+
+				Waiters.fetch_add(1, std::memory_order_seq_cst);
+				{
+					std::unique_lock<std::mutex> Lock(Mutex);
+
+					Result = Condition.wait_until(Lock, Deadline, Ready);
+				}
+				Waiters.fetch_sub(1, std::memory_order_seq_cst);
+
+				return Result;
+			}
+	};
+}
@@ -0,0 +1,103 @@
+# pragma once
+
+# include <unordered_map>
+# include <functional>
+# include <cstdint>
+# include <cstddef>
+# include <atomic>
+# include <memory>
+# include <thread>
+# include <mutex>
+# include <map>
+
+namespace net
+{
+	struct connection;
+
+	/*
+	*   handler  --park()-->  *-------------------*  --readable-->  Dispatch  -->  handler
+	*                         |  epoll set        |
+	*                         |  idle deadlines   |  --timeout-->  closed
+	*                         *-------------------*
+	*
+	*	Keep-alive connections which are waiting for the next request. They are not holding a worker -
+	*	all of them are in one epoll set of the parking thread, and when a connection has bytes to read
+	*	it is given to Dispatch, net::server calls its handler again. If the peer has closed the connection
+	*	or it stays idle for IdleTimeout, it is closed here, so handler sees only sockets with data.
+	*
+	*	Thread is started by the first park(). Parked connections are closed by the destructor or close().
+	*/
+	class parking final
+	{
+		/*
+		*	Idle deadlines ordered by time, so a connection which is parked after the timeout is lowered
+		*	does not wait for the older ones
+		*/
+		using deadlines = std::multimap<std::int64_t, int>;
+
+		struct parked final
+		{
+			std::unique_ptr<connection> Connection;
+			deadlines::iterator Deadline;
+		};
+
+		int Poller;
+		int Wake;
+		std::atomic<bool> Enabled;
+		std::atomic<bool> Closing;
+		std::atomic<std::int64_t> IdleTimeout;
+		std::atomic<std::size_t> Count;
+		std::function<void(std::unique_ptr<connection>)> Dispatch;
+		std::once_flag Started;
+		std::mutex Mutex;
+		std::mutex Dispatching;
+		std::unordered_map<int, parked> Parked;
+		deadlines Deadlines;
+		std::thread Thread;
+
+		public:
+			explicit parking(std::function<void(std::unique_ptr<connection>)> __Dispatch);
+
+			explicit parking(parking const&) = delete;
+			explicit parking(parking const&&) = delete;
+
+			~parking(void);
+
+			/*
+			*	Connection is closed at once if it can not be watched
+			*/
+			void park(std::unique_ptr<connection> Connection);
+
+			/*
+			*	Nanoseconds, applies to connections which are parked after the call. 60 seconds by default
+			*/
+			void set_timeout(const std::int64_t Timeout);
+
+			std::int64_t get_timeout(void) const;
+
+			std::size_t size(void) const;
+
+			/*
+			*	Closes parked connections, the ones which are parked after it are closed at once.
+			*	Dispatch is not called after it returns.
+			*	Server calls it on drain and destruction, keep-alive clients see the close between their requests
+			*/
+			void close(void);
+
+		private:
+			void work(void);
+
+			/*
+			*	Closes connections which are idle for too long, returns milliseconds until the next deadline or -1
+			*/
+			int expire(void);
+
+			void resume(const int Descriptor, const std::uint32_t Events);
+	};
+
+	/*
+	*	Gives connection back to net::server which has dispatched it: the handler is called again
+	*	when the next request arrives. Connection is closed if it does not come from a server
+	*/
+	void park(std::unique_ptr<connection> Connection);
+}
@@ -0,0 +1,94 @@
+# pragma once
+
+# include <string_view>
+# include <cstddef>
+# include <string>
+
+namespace net
+{
+	/*
+	*	Block of memory from per-thread pool of reusable buffers.
+	*
+	*	Every buffer has capacity of Capacity bytes, size() is count of bytes which are used.
+	*	Blocks are returned to the pool of the thread which destroys the buffer, threads
+	*	exchange them by halves through a global list - same as memory of net::connection.
+	*	So connection::read() and the response which is built in place do not go to the allocator.
+	*/
+	class buffer final
+	{
+		char* Data;
+		std::size_t Size;
+
+		public:
+			static constexpr std::size_t Capacity = 16384;
+
+			buffer(void);
+
+			/*
+			*	Takes ownership of Block which has been detached from another buffer
+			*/
+			explicit buffer(char* Block, const std::size_t __Size);
+
+			buffer(buffer&& Other) noexcept;
+
+			buffer& operator=(buffer&& Other) noexcept;
+
+			explicit buffer(buffer const&) = delete;
+
+			~buffer(void);
+
+			char* data(void);
+
+			char const* data(void) const;
+
+			std::size_t size(void) const;
+
+			std::size_t capacity(void) const;
+
+			/*
+			*	Size is clamped by Capacity
+			*/
+			void resize(const std::size_t __Size);
+
+			/*
+			*	Appends Text as much as it fits and returns count of bytes which are appended
+			*/
+			std::size_t append(const std::string_view Text);
+
+			std::string_view view(void) const;
+
+			/*
+			*	Gives up the block without returning it to the pool, buffer is empty after.
+			*	It is how net::entry carries prefetched bytes, the block goes back by buffer(Block, Size) or recycle()
+			*/
+			char* detach(void);
+
+			static void recycle(char* Block);
+
+		private:
+			void release(void);
+	};
+
+	/*
+	*	Read-only file for connection::sendfile(). It is opened once, so a static response which is
+	*	served to every client is never read into user space
+	*/
+	class file final
+	{
+		int Descriptor;
+		std::size_t Size;
+
+		public:
+			explicit file(std::string const& Path);
+
+			file(file&& Other) noexcept;
+
+			explicit file(file const&) = delete;
+
+			~file(void);
+
+			int descriptor(void) const;
+
+			std::size_t size(void) const;
+	};
+}
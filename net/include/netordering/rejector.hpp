@@ -0,0 +1,110 @@
+# pragma once
+
+# include <string_view>
+# include <functional>
+# include <cstddef>
+# include <atomic>
+# include <memory>
+# include <string>
+# include <thread>
+
+# include <netordering/notifier.hpp>
+# include <netordering/context.hpp>
+# include <netordering/entry.hpp>
+# include <netordering/ring.hpp>
+
+constexpr std::string_view ErrorMessage = "Sorry";
+
+namespace net
+{
+	struct connection;
+
+	/*
+	*	What is done with a client which does not fit into the order(Limit or LimitOrder is reached)
+	*
+	*	`message`     - sends rejection_policy::message(ErrorMessage by default) and closes the socket
+	*	`reset`       - closes the socket with SO_LINGER 0, client gets RST
+	*	`unavailable` - sends "HTTP/1.1 503 Service Unavailable" with Retry-After and closes the socket
+	*	`backlog`     - client is not accepted at all, it is waiting in the kernel backlog until order has a free place
+	*	`callback`    - rejection_policy::handler gets the connection, it is called on io_context of the connection
+	*	                (see net::context_pool), so it must not block: start async operations and return
+	*/
+	enum class rejection
+	{
+		message,
+		reset,
+		unavailable,
+		backlog,
+		callback
+	};
+
+	struct rejection_policy final
+	{
+		rejection kind = rejection::message;
+		std::string message = std::string(ErrorMessage);
+		std::size_t retry_after = 1;
+		std::function<void(std::unique_ptr<connection>)> handler = nullptr;
+	};
+
+	/*
+	*   listener / queue  --(entry, policy)-->  *-------------*  -->  rejector thread  -->  send() / RST / handler
+	*                                           |    ring     |
+	*                                           *-------------*
+	*
+	*	Rejected clients are not served on the accept or aggregation thread - they are pushed into lock-free order
+	*	and the rejector thread applies the policy. Sockets are written only with MSG_DONTWAIT, so a slow client
+	*	can not stall the rejector too. Handler of `callback` is posted to io_context of the connection and is not
+	*	called by the rejector thread, so a slow handler does not hold up rejections of other ports and servers.
+	*
+	*	If there are already MaxPending rejected clients, the next ones are reset in place - it never blocks either.
+	*
+	*	shared() is a process-wide rejector which is used by listeners and queues.
+	*/
+	class rejector final
+	{
+		static constexpr std::size_t MaxPending = 65536;
+
+		struct rejected final
+		{
+			entry Entry;
+			std::shared_ptr<const rejection_policy> Policy;
+		};
+
+		std::atomic<bool> Stopping;
+		notifier Pending;
+		ring<rejected> Order;
+		std::shared_ptr<context_pool> Contexts;
+		std::thread Thread;
+
+		public:
+			rejector(void);
+
+			/*
+			*	Connections of `callback` policy are built on io_contexts of Contexts
+			*/
+			explicit rejector(std::shared_ptr<context_pool> __Contexts);
+
+			explicit rejector(rejector const&) = delete;
+			explicit rejector(rejector const&&) = delete;
+
+			~rejector(void);
+
+			/*
+			*	Returns false if rejector is full and client has been reset in place
+			*/
+			bool reject(entry const& Entry, std::shared_ptr<const rejection_policy> const& Policy);
+
+			std::size_t size(void) const;
+
+			static std::shared_ptr<rejector> shared(void);
+
+		private:
+			void work(void);
+
+			void apply(entry const& Entry, std::shared_ptr<const rejection_policy> const& Policy);
+
+			static void reset(entry const& Entry);
+
+			static void send(entry const& Entry, std::string_view Message);
+	};
+}
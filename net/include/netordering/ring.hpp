@@ -0,0 +1,340 @@
+# pragma once
+
+# include <cstdint>
+# include <cstddef>
+# include <optional>
+# include <atomic>
+# include <memory>
+# include <vector>
+# include <mutex>
+
+namespace net
+{
+	/*
+	*                  *----------*     *----------*     *----------*
+	*   pop()   <--    | segment  | --> | segment  | --> | segment  |    <--  try_push()
+	*   (Head)         *----------*     *----------*     *----------*         (Tail)
+	*
+	*	Lock-free multi-producer multi-consumer FIFO for connections order.
+	*
+	*	Every segment is a bounded ring of cells with sequence numbers. While the order is not deeper than capacity
+	*	of the segment, there is only one segment and it is used round and round - so ring sized from the limit
+	*	never allocates after construction.
+	*
+	*	When segment is full(limit is 0 or was raised above capacity) producer seals it and links a new segment,
+	*	this is the only place where mutex is taken. Drained segments are not freed but reused, so memory
+	*	is bounded by the deepest order which has been seen.
+	*
+	*	try_push() rejects if there are already Limit values inside(0 means no limit) and leaves the value to caller,
+	*	so rejecting is still on the caller side.
+	*
+	*	Positions are 63-bit counters which are never repeated inside one ring, so thread which is
+	*	looking at reused segment can not succeed with old position.
+	*/
+	template<typename Type>
+	class ring final
+	{
+		static constexpr std::uint64_t Closed = std::uint64_t(1) << 63;
+		static constexpr std::size_t MinCapacity = 64;
+		static constexpr std::size_t MaxCapacity = std::size_t(1) << 20;
+
+		struct cell final
+		{
+			std::atomic<std::uint64_t> Sequence;
+			Type Value;
+		};
+
+		struct segment final
+		{
+			alignas(64) std::atomic<std::uint64_t> Head;
+			alignas(64) std::atomic<std::uint64_t> Tail;
+			alignas(64) std::atomic<std::uint64_t> Done;
+			std::atomic<std::uint64_t> Base;
+			std::atomic<segment*> Next;
+			std::atomic<bool> Retired;
+			const std::uint64_t Mask;
+			std::unique_ptr<cell[]> Cells;
+
+			explicit segment(const std::size_t Capacity) : Head(0), Tail(0), Done(0), Base(0), Next(nullptr), Retired(false),
+				Mask(Capacity - 1), Cells(std::make_unique<cell[]>(Capacity))
+			{ }
+
+			void reset(const std::uint64_t __Base)
+			{
+				for (std::uint64_t Index = 0; Index <= Mask; Index += 1)
+					Cells[Index].Sequence.store(__Base + Index, std::memory_order_relaxed);
+
+				Base.store(__Base, std::memory_order_relaxed);
+				Head.store(__Base, std::memory_order_relaxed);
+				Done.store(0, std::memory_order_relaxed);
+				Next.store(nullptr, std::memory_order_relaxed);
+				Retired.store(false, std::memory_order_relaxed);
+				Tail.store(__Base, std::memory_order_release);
+			}
+		};
+
+		alignas(64) std::atomic<segment*> Head;
+		alignas(64) std::atomic<segment*> Tail;
+		alignas(64) std::atomic<std::size_t> Size;
+		std::atomic<std::size_t> Capacity;
+		std::mutex SegmentsMutex;
+		std::uint64_t NextBase;
+		std::vector<segment*> Free;
+		std::vector<std::unique_ptr<segment>> Segments;
+
+		public:
+			ring(void) : ring(0)
+			{ }
+
+			/*
+			*	Capacity is rounded up to power of two, 0 means default capacity of unbounded order
+			*/
+			explicit ring(const std::size_t __Capacity) : Size(0), Capacity(round(__Capacity)), NextBase(0)
+			{
+				segment* First = allocate(Capacity.load(std::memory_order_relaxed));
+
+				Head.store(First, std::memory_order_relaxed);
+				Tail.store(First, std::memory_order_release);
+			}
+
+			explicit ring(ring const&) = delete;
+			explicit ring(ring const&&) = delete;
+
+			~ring(void) = default;
+
+			/*
+			*	Hint for capacity of the next segment, call it when limit is changed
+			*/
+			void reserve(const std::size_t __Capacity)
+			{
+				Capacity.store(round(__Capacity), std::memory_order_relaxed);
+			}
+
+			std::size_t size(void) const
+			{
+				return Size.load(std::memory_order_acquire);
+			}
+
+			bool empty(void) const
+			{
+				return size() == 0;
+			}
+
+			/*
+			*	Moves Value inside and returns true, or returns false and does not touch Value if order has Limit values
+			*/
+			bool try_push(Type& Value, const std::size_t Limit)
+			{
+				if (Size.fetch_add(1, std::memory_order_acq_rel) >= Limit && Limit != 0)
+				{
+					Size.fetch_sub(1, std::memory_order_acq_rel);
+					return false;
+				}
+
+				while (true)
+				{
+					segment* Segment = Tail.load(std::memory_order_acquire);
+					std::uint64_t Position = Segment->Tail.load(std::memory_order_acquire);
+
+					if (Position & Closed)
+					{
+						grow(Segment);
+						continue;
+					}
+
+					cell& Cell = Segment->Cells[(Position - Segment->Base.load(std::memory_order_acquire)) & Segment->Mask];
+					const std::uint64_t Sequence = Cell.Sequence.load(std::memory_order_acquire);
+
+					if (Sequence == Position)
+					{
+						if (Segment->Tail.compare_exchange_weak(Position, Position + 1, std::memory_order_acq_rel))
+						{
+							Cell.Value = std::move(Value);
+							Cell.Sequence.store(Position + 1, std::memory_order_release);
+
+							return true;
+						}
+					}
+					else if (Sequence < Position)
+						Segment->Tail.compare_exchange_strong(Position, Position | Closed, std::memory_order_acq_rel);
+				}
+			}
+
+			/*
+			*	Moves first values of Values inside, as many as Limit allows, and returns count of them.
+			*	Positions for all values which are fit in the tail segment are claimed by one CAS.
+			*	The rest of Values is not touched, caller is rejecting them
+			*/
+			std::size_t try_push_bulk(std::vector<Type>& Values, const std::size_t Limit)
+			{
+				std::size_t Count = Values.size();
+
+				if (Limit == 0)
+					Size.fetch_add(Count, std::memory_order_acq_rel);
+				else
+				{
+					std::size_t Current = Size.load(std::memory_order_acquire);
+
+					do
+						Count = std::min(Values.size(), Current < Limit ? Limit - Current : 0);
+					while (Count != 0 && !Size.compare_exchange_weak(Current, Current + Count, std::memory_order_acq_rel));
+				}
+
+				std::size_t Pushed = 0;
+				while (Pushed < Count)
+				{
+					segment* Segment = Tail.load(std::memory_order_acquire);
+					std::uint64_t Position = Segment->Tail.load(std::memory_order_acquire);
+
+					if (Position & Closed)
+					{
+						grow(Segment);
+						continue;
+					}
+
+					const std::uint64_t Base = Segment->Base.load(std::memory_order_acquire);
+					std::uint64_t Claim = 0;
+
+					while (Pushed + Claim < Count && Claim <= Segment->Mask
+						&& Segment->Cells[(Position + Claim - Base) & Segment->Mask].Sequence.load(std::memory_order_acquire) == Position + Claim)
+						Claim += 1;
+
+					if (Claim == 0)
+					{
+						if (Segment->Cells[(Position - Base) & Segment->Mask].Sequence.load(std::memory_order_acquire) < Position)
+							Segment->Tail.compare_exchange_strong(Position, Position | Closed, std::memory_order_acq_rel);
+						continue;
+					}
+
+					if (Segment->Tail.compare_exchange_weak(Position, Position + Claim, std::memory_order_acq_rel))
+						for (std::uint64_t Index = 0; Index < Claim; Index += 1, Pushed += 1)
+						{
+							cell& Cell = Segment->Cells[(Position + Index - Base) & Segment->Mask];
+
+							Cell.Value = std::move(Values[Pushed]);
+							Cell.Sequence.store(Position + Index + 1, std::memory_order_release);
+						}
+				}
+				return Count;
+			}
+
+			[[ nodiscard ]]
+			std::optional<Type> pop(void)
+			{
+				while (true)
+				{
+					segment* Segment = Head.load(std::memory_order_acquire);
+					std::uint64_t Position = Segment->Head.load(std::memory_order_acquire);
+
+					if (Head.load(std::memory_order_acquire) != Segment)
+						continue;
+
+					cell& Cell = Segment->Cells[(Position - Segment->Base.load(std::memory_order_acquire)) & Segment->Mask];
+					const std::uint64_t Sequence = Cell.Sequence.load(std::memory_order_acquire);
+
+					if (Sequence == Position + 1)
+					{
+						if (Segment->Head.compare_exchange_weak(Position, Position + 1, std::memory_order_acq_rel))
+						{
+							std::optional<Type> Result(std::move(Cell.Value));
+
+							Cell.Sequence.store(Position + Segment->Mask + 1, std::memory_order_release);
+							Size.fetch_sub(1, std::memory_order_acq_rel);
+
+							Segment->Done.fetch_add(1, std::memory_order_acq_rel);
+							retire(Segment);
+
+							return Result;
+						}
+					}
+					else if (Sequence < Position + 1)
+					{
+						const std::uint64_t Sealed = Segment->Tail.load(std::memory_order_acquire);
+
+						if (!(Sealed & Closed) || (Sealed & ~Closed) != Position)
+							return std::nullopt;
+
+						segment* Next = Segment->Next.load(std::memory_order_acquire);
+						if (Next == nullptr)
+							return std::nullopt;
+
+						segment* Expected = Segment;
+						Head.compare_exchange_strong(Expected, Next, std::memory_order_acq_rel);
+						retire(Segment);
+					}
+				}
+			}
+
+		private:
+			static std::size_t round(const std::size_t __Capacity)
+			{
+				std::size_t Result = MinCapacity;
+
+				while (Result < __Capacity && Result < MaxCapacity)
+					Result <<= 1;
+				return Result;
+			}
+
+			segment* allocate(const std::size_t __Capacity)
+			{
+				segment* Result = nullptr;
+
+				for (typename std::vector<segment*>::iterator Iterator = Free.begin(); Iterator != Free.end(); Iterator += 1)
+					if ((*Iterator)->Mask + 1 >= __Capacity)
+					{
+						Result = *Iterator;
+						Free.erase(Iterator);
+						break;
+					}
+
+				if (Result == nullptr)
+				{
+					Segments.push_back(std::make_unique<segment>(__Capacity));
+					Result = Segments.back().get();
+				}
+
+				Result->reset(NextBase);
+				NextBase += Result->Mask + 1;
+
+				return Result;
+			}
+
+			void grow(segment* Segment)
+			{
+				std::lock_guard<std::mutex> SegmentsLockGuard(SegmentsMutex);
+
+				if (Tail.load(std::memory_order_acquire) != Segment || Segment->Next.load(std::memory_order_acquire) != nullptr)
+					return;
+
+				const std::size_t Sealed = Segment->Mask + 1;
+				const std::size_t Wanted = Size.load(std::memory_order_acquire) >= Sealed ? std::min(Sealed * 2, MaxCapacity) : Sealed;
+				segment* Next = allocate(std::max(Capacity.load(std::memory_order_relaxed), Wanted));
+
+				Segment->Next.store(Next, std::memory_order_release);
+				Tail.store(Next, std::memory_order_release);
+			}
+
+			void retire(segment* Segment)
+			{
+				const std::uint64_t Sealed = Segment->Tail.load(std::memory_order_acquire);
+
+				if (!(Sealed & Closed))
+					return;
+				if (Segment->Done.load(std::memory_order_acquire) != (Sealed & ~Closed) - Segment->Base.load(std::memory_order_acquire))
+					return;
+
+				segment* Next = Segment->Next.load(std::memory_order_acquire);
+				if (Next == nullptr)
+					return;
+
+				segment* Expected = Segment;
+				Head.compare_exchange_strong(Expected, Next, std::memory_order_acq_rel);
+
+				if (Head.load(std::memory_order_acquire) == Segment || Segment->Retired.exchange(true, std::memory_order_acq_rel))
+					return;
+
+				std::lock_guard<std::mutex> SegmentsLockGuard(SegmentsMutex);
+				Free.push_back(Segment);
+			}
+	};
+}
@@ -0,0 +1,187 @@
+# pragma once
+
+# include <type_traits>
+# include <cstddef>
+# include <memory>
+# include <vector>
+
+# include <sched.h>
+
+# include <netordering/net.hpp>
+
+namespace net
+{
+	/*
+	*                   *->  shard 1: listeners -> queue -> workers + io_contexts   (CPUs of shard 1)
+	*                  /
+	*   Port(-s)  ----*--->  shard 2: listeners -> queue -> workers + io_contexts   (CPUs of shard 2)
+	*                  \
+	*                   *->  shard N: ...
+	*
+	*	Several independent net::server instances on the same ports. Every shard has its own SO_REUSEPORT listeners,
+	*	so the kernel spreads clients between shards, its own order, background threads, workers, context_pool
+	*	and rejector(see net::resources).
+	*	Shards share nothing on the fast path.
+	*
+	*	topology::cpus is the CPU set(all CPUs of the process by default), it is split to topology::shards equal slices
+	*	(one shard per CPU by default). Every thread of a shard is pinned to its slice - threads inherit affinity of the
+	*	thread which creates them, so constructor and setters of this class create them from a thread pinned to the slice.
+	*	Workers of a shard are limited by count of its CPUs, change it by set_limit_executor().
+	*
+	*	set_stealing(true) lets a shard with empty order take connections from orders of other shards,
+	*	it looks at them once per millisecond while it is idle. Stolen connection is built on io_contexts of the shard
+	*	which serves it. Disabled by default.
+	*
+	*	snapshot() sums metrics of all shards.
+	*/
+	class sharded_server final
+	{
+		public:
+			struct topology final
+			{
+				std::size_t shards = 0;
+				std::vector<std::size_t> cpus;
+			};
+
+			/*
+			*	Pins calling thread to Cpus while it is alive, previous affinity is restored after
+			*/
+			class pinned final
+			{
+				cpu_set_t Previous;
+				bool Restore;
+
+				public:
+					explicit pinned(std::vector<std::size_t> const& Cpus);
+
+					explicit pinned(pinned const&) = delete;
+					explicit pinned(pinned const&&) = delete;
+
+					~pinned(void);
+			};
+
+		private:
+			std::vector<std::vector<std::size_t>> Cpus;
+			std::vector<std::shared_ptr<server>> Shards;
+
+		public:
+			template<typename Callback, typename... Args>
+			sharded_server(topology Topology, const Callback CallBack, Args... Ports)
+			{
+				plan(std::move(Topology));
+
+				// Process-wide ones are created before any pinning, so their threads are not left on the CPUs of the first shard
+				context_pool::shared();
+				rejector::shared();
+
+				for (std::size_t Index = 0; Index < Cpus.size(); Index += 1)
+				{
+					pinned Pinned(Cpus[Index]);
+					std::shared_ptr<context_pool> Contexts = std::make_shared<context_pool>(Cpus[Index].size());
+
+					// Ports are added after the pool and rejector of the shard, no client uses the process-wide ones
+					Shards.push_back(std::make_shared<server>(CallBack, resources{ Contexts, std::make_shared<rejector>(Contexts) }, Ports...));
+					if (Shards.back()->get_limit_executor() != 0)
+						Shards.back()->set_limit_executor(Cpus[Index].size());
+				}
+				connect();
+			}
+
+			template<typename Callback, typename... Args>
+				requires (!std::is_same_v<Callback, topology>)
+			sharded_server(const Callback CallBack, Args... Ports) : sharded_server(topology(), CallBack, Ports...)
+			{ }
+
+			explicit sharded_server(sharded_server const&) = delete;
+			explicit sharded_server(sharded_server const&&) = delete;
+
+			~sharded_server(void);
+
+			std::size_t size(void) const;
+
+			server& shard(const std::size_t Index);
+
+			std::vector<std::size_t> const& cpus(const std::size_t Index) const;
+
+			void set_stealing(const bool Stealing);
+
+			void set_backend(const backend Kind);
+
+			/*
+			*	Limit of workers of every shard
+			*/
+			template<typename Type>
+			void set_limit_executor(const Type Limit)
+			{
+				static_assert(std::is_integral_v<Type>, "Given Limit is not integral");
+
+				for (std::size_t Index = 0; Index < Shards.size(); Index += 1)
+				{
+					pinned Pinned(Cpus[Index]);
+
+					Shards[Index]->set_limit_executor(Limit);
+				}
+			}
+
+			/*
+			*	Limit of order of every shard
+			*/
+			template<typename Type>
+			void set_limit_order(const Type Limit)
+			{
+				static_assert(std::is_integral_v<Type>, "Given Limit is not integral");
+
+				for (auto& Shard : Shards)
+					Shard->set_limit_order(Limit);
+			}
+
+			template<typename Type>
+			void add(const Type Port)
+			{
+				static_assert(std::is_integral_v<Type>, "Given Port is not integral");
+
+				for (std::size_t Index = 0; Index < Shards.size(); Index += 1)
+				{
+					pinned Pinned(Cpus[Index]);
+
+					Shards[Index]->add(Port);
+				}
+			}
+
+			template<typename Type>
+			void remove(const Type Port)
+			{
+				static_assert(std::is_integral_v<Type>, "Given Port is not integral");
+
+				for (auto& Shard : Shards)
+					Shard->remove(Port);
+			}
+
+			template<typename Rep, typename Period>
+			void set_idle_timeout(const std::chrono::duration<Rep, Period> Timeout)
+			{
+				for (auto& Shard : Shards)
+					Shard->set_idle_timeout(Timeout);
+			}
+
+			/*
+			*	Every shard stops accepting at once and then is drained up to the same Deadline, see server::drain()
+			*/
+			bool drain(const std::chrono::steady_clock::time_point Deadline);
+
+			template<typename Rep, typename Period>
+			bool drain(const std::chrono::duration<Rep, Period> Timeout)
+			{
+				return drain(std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(Timeout));
+			}
+
+			std::vector<std::size_t> listeners(void);
+
+			metrics snapshot(void);
+
+		private:
+			void plan(topology Topology);
+
+			void connect(void);
+	};
+}
@@ -0,0 +1,172 @@
+# pragma once
+
+# include <cstdint>
+# include <cstddef>
+# include <atomic>
+
+# ifdef NETORDERING_IO_URING
+#	include <linux/io_uring.h>
+#	include <cerrno>
+# endif
+
+namespace net
+{
+	/*
+	*	How listeners wait for clients and how net::connection does its I/O.
+	*
+	*	`epoll` - readiness: epoll_wait() on the listening socket, then accept4() in a loop until EAGAIN,
+	*	          read()/write() of connection are plain recv()/sendmsg()
+	*	`io_uring` - completion: one multishot accept stays armed in the kernel, every io_uring_enter() returns
+	*	          a batch of accepted sockets. read() takes a buffer which kernel has picked from the provided
+	*	          buffer ring, write() of many parts is one batch of linked sendmsg()
+	*
+	*	io_uring is built if NETORDERING_IO_URING option of CMake is ON and <linux/io_uring.h> is found.
+	*	If it is not built, is not permitted(seccomp of containers) or kernel is older than 5.19,
+	*	set_backend(backend::io_uring) falls back to epoll, get_backend() tells which one is used.
+	*/
+	enum class backend
+	{
+		epoll,
+		io_uring
+	};
+
+# ifdef NETORDERING_IO_URING
+	/*
+	*	Minimal io_uring on raw system calls, liburing is not required.
+	*	Instance is used by one thread: sqe() prepares entries, submit() passes all of them by one io_uring_enter()
+	*	and waits for Wait completions, reap() walks completions which are ready. cancel() empties the ring when
+	*	submit() has failed, so the caller may fall back to plain system calls.
+	*
+	*	provide() registers ring of buffers for IOSQE_BUFFER_SELECT, recycle() gives buffer back to the kernel.
+	*/
+	class uring final
+	{
+		int Descriptor;
+		unsigned* SqHead;
+		unsigned* SqTail;
+		unsigned SqMask;
+		unsigned SqEntries;
+		unsigned* SqArray;
+		io_uring_sqe* Sqes;
+		unsigned* CqHead;
+		unsigned* CqTail;
+		unsigned CqMask;
+		io_uring_cqe* Cqes;
+		void* SqRing;
+		void* CqRing;
+		std::size_t SqRingSize;
+		std::size_t CqRingSize;
+		std::size_t SqesSize;
+		unsigned Tail;
+		unsigned Submitted;
+		std::size_t InFlight;
+		io_uring_buf_ring* Buffers;
+		std::size_t BuffersSize;
+		unsigned BuffersMask;
+		std::uint16_t BuffersTail;
+		std::uint16_t BuffersGroup;
+
+		public:
+			/*
+			*	Throws std::system_error if kernel refuses to create the ring
+			*/
+			explicit uring(const unsigned Entries);
+
+			explicit uring(uring const&) = delete;
+			explicit uring(uring const&&) = delete;
+
+			~uring(void);
+
+			/*
+			*	Whether io_uring works here and knows all operations which are used, checked once per process
+			*/
+			static bool supported(void);
+
+			/*
+			*	Zeroed submission entry, nullptr if submission queue is full - submit() first
+			*/
+			io_uring_sqe* sqe(void);
+
+			/*
+			*	Returns count of submitted entries or -errno
+			*/
+			int submit(const unsigned Wait);
+
+			/*
+			*	Calls Callback(io_uring_cqe const&) for every completion which is ready, returns their count
+			*/
+			template<typename Function>
+			std::size_t reap(Function&& Callback)
+			{
+				std::atomic_ref<unsigned> Head(*CqHead);
+				const unsigned Last = std::atomic_ref<unsigned>(*CqTail).load(std::memory_order_acquire);
+				unsigned Current = Head.load(std::memory_order_relaxed);
+				std::size_t Result = 0;
+
+				for (; Current != Last; Current += 1, Result += 1)
+				{
+					io_uring_cqe const& Completion = Cqes[Current & CqMask];
+
+					// Every request ends with one completion without IORING_CQE_F_MORE
+					if (!(Completion.flags & IORING_CQE_F_MORE))
+						InFlight -= 1;
+					Callback(Completion);
+					Head.store(Current + 1, std::memory_order_release);
+				}
+				return Result;
+			}
+
+			/*
+			*	Takes back entries which are prepared but not submitted, Callback gets a completion with -ECANCELED
+			*	for each of them. Then cancels all requests in flight and reaps their completions into Callback until
+			*	kernel has no one. false if kernel does not let to do it, the ring must be destroyed then
+			*/
+			template<typename Function>
+			bool cancel(Function&& Callback)
+			{
+				static constexpr std::uint64_t CancelTag = ~std::uint64_t(0);
+
+				for (; Tail != Submitted; Tail -= 1)
+				{
+					io_uring_cqe Completion = { };
+
+					Completion.user_data = Sqes[(Tail - 1) & SqMask].user_data;
+					Completion.res = -ECANCELED;
+					Callback(static_cast<io_uring_cqe const&>(Completion));
+				}
+				std::atomic_ref<unsigned>(*SqTail).store(Tail, std::memory_order_release);
+
+				if (InFlight == 0)
+					return true;
+
+				// Submission queue is empty now, so there is a place for the entry
+				io_uring_sqe* Cancel = sqe();
+
+				Cancel->opcode = IORING_OP_ASYNC_CANCEL;
+				Cancel->cancel_flags = IORING_ASYNC_CANCEL_ANY | IORING_ASYNC_CANCEL_ALL;
+				Cancel->user_data = CancelTag;
+
+				while (InFlight != 0)
+				{
+					if (submit(1) < 0)
+						return false;
+					reap([&](io_uring_cqe const& Completion) -> void {
+						if (Completion.user_data != CancelTag)
+							Callback(Completion);
+					});
+				}
+				return true;
+			}
+
+			/*
+			*	Registers ring of Entries(power of two) buffers as group Group, false if kernel does not support it
+			*/
+			bool provide(const std::uint16_t Group, const unsigned Entries);
+
+			void recycle(void* Address, const unsigned Length, const std::uint16_t Id);
+
+		private:
+			void release(void);
+	};
+# endif
+}
@@ -1,52 +1,45 @@
-# include <boost/asio.hpp>
+# include <utility>
 
-# include <openssl/evp.h>
+# include <boost/asio.hpp>
 
 # include <iostream>
 
 # include <netordering/net.hpp>
 
-std::string make_string(boost::asio::streambuf& streambuf)
-{
-	return std::string{boost::asio::buffers_begin(streambuf.data()), boost::asio::buffers_end(streambuf.data())};
-}
-
-std::string hash(std::string const& String, const EVP_MD* HashFunction)
-{
-	if (String.size() == 0)
-		return "";
-
-	std::pair<std::array<unsigned char, EVP_MAX_MD_SIZE>, unsigned int> Bytes;
-	EVP_MD_CTX* Context = EVP_MD_CTX_new();
-
-	EVP_DigestInit(Context, HashFunction);
-	EVP_DigestUpdate(Context, String.data(), String.size());
-	EVP_DigestFinal(Context, Bytes.first.data(), &Bytes.second);
-
-	std::stringstream MainSS;
-	for (std::size_t Iter = 0; Iter < Bytes.second; Iter += 1)
-	{
-		std::stringstream ss;
-		ss << std::hex << (int)Bytes.first[Iter];
-		std::string Byte = ss.str();
-		MainSS << (Byte.size() == 1 ? '0' + Byte : Byte);
-	}
-	return MainSS.str();
-}
-
 class A final
 {
+	// Server copies its callback, copies share the cache
+	std::shared_ptr<net::response_cache> Responses = std::make_shared<net::response_cache>(16);
+
 	public:
 		// Type in your browser localhost
 		void service80(const std::unique_ptr<net::connection>&& Connection)
 		{
-			boost::asio::streambuf StreamBuffer;
-			std::string Result = "Hello from server";
-			std::string Hash = "HTTP/1.0 200 OK\n\n<p>(SHA256)(" + Result + ") = " + hash(Result, EVP_sha256()) + "</p>";
-			std::cout << "Write: " << Hash << std::endl;
-
-			boost::asio::read_until(*Connection->socket, StreamBuffer, "\0");
-			Connection->socket->write_some(boost::asio::buffer(Hash.c_str(), Hash.size()));
+			boost::system::error_code Error;
+			std::string_view Result = "Hello from server";
+			net::digest Hash = net::hash(net::algorithm::sha256, Result);
+
+			// Request is read into pooled buffer and parsed in place
+			net::buffer Data = Connection->read(Error);
+			net::request_view Request;
+
+			if (net::parse(Data.view(), Request) == net::framing::complete)
+			{
+				std::cout << Request.method << ' ' << Request.target << std::endl;
+				if (Hash.matches(Request.header("If-None-Match")))
+				{
+					Connection->write({ "HTTP/1.0 304 Not Modified\nETag: ", Hash.etag(), "\n\n" }, Error);
+					return;
+				}
+			}
+
+			// Response is rendered once for every content, digest of the content is its key
+			std::shared_ptr<const std::string> Response = Responses->get(Hash, [&](void) -> std::string {
+				return "HTTP/1.0 200 OK\nETag: " + Hash.etag() + "\n\n<p>(SHA256)(" + std::string(Result) + ") = " + Hash.hex() + "</p>";
+			});
+
+			std::cout << "Write: " << Hash.hex() << std::endl;
+			Connection->write({ *Response }, Error);
 			std::this_thread::sleep_for(std::chrono::milliseconds(5));
 		}
 
@@ -68,18 +61,16 @@ class A final
          */
 		void service13456(const std::unique_ptr<net::connection>&& Connection)
 		{
-			boost::asio::streambuf StreamBuffer;
-			boost::asio::read_until(*Connection->socket, StreamBuffer, "\0");
-
-			std::string Read = make_string(StreamBuffer);
+			boost::system::error_code Error;
+			net::buffer Read = Connection->read(Error);
 
-			std::cout << "Read: " << Read << std::endl;
+			std::cout << "Read: " << Read.view() << std::endl;
 
-			std::string Hash = "(MD5)(" + Read + ") = " + hash(Read, EVP_md5());
+			std::string Hash = net::hash(net::algorithm::md5, Read.view()).hex();
 
 			std::cout << "Write: " << Hash << std::endl;
 
-			Connection->socket->write_some(boost::asio::buffer(Hash.c_str(), Hash.size()));
+			Connection->write({ "(MD5)(", Read.view(), ") = ", Hash }, Error);
 		}
 
 		// This overloaded operator will be called in Server
@@ -110,5 +101,6 @@ int main(void)
 
 	Server.set_limit_executor(3); // Only 3 clients will be executed in parallel. Others will waiting for they order
 	Server.set_limit_order(2); // Order can be size of 2. Not more. If there will be new connection it will send error-message and close connection
+	Server.set_prefetch(80, std::chrono::seconds(5)); // Clients of port 80 get into the order only with their first bytes, silent ones are closed after 5 seconds
 	while (true) { } // There is while(true) because will be called distructor and Server will listen last connections on specified ports(but will not call Callback for them in another thread. Accepting without exec). For demonstration purposes only
 }
\ No newline at end of file
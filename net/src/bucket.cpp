@@ -0,0 +1,101 @@
+# include <netordering/bucket.hpp>
+
+# include <algorithm>
+# include <limits>
+# include <chrono>
+
+static constexpr std::int64_t Second = 1000000000;
+
+static constexpr std::int64_t interval(const std::uint64_t Settings)
+{
+	return static_cast<std::int64_t>(Settings >> 32);
+}
+
+static constexpr std::int64_t burst(const std::uint64_t Settings)
+{
+	return static_cast<std::int64_t>(Settings & 0xffffffff);
+}
+
+net::token_bucket::token_bucket(void) : Settings(0), Full(0)
+{ }
+
+void net::token_bucket::set(const std::size_t Rate, const std::size_t Burst, const std::int64_t Now)
+{
+	if (Rate == 0)
+	{
+		Settings.store(0, std::memory_order_release);
+		return;
+	}
+
+	// Rate above one client per nanosecond is not distinguished from it, Interval of one second fits 32 bits
+	const std::int64_t Next = std::max<std::int64_t>(Second / static_cast<std::int64_t>(std::min<std::size_t>(Rate, Second)), 1);
+	const std::int64_t MaxBurst = std::min<std::int64_t>(std::numeric_limits<std::int64_t>::max() / 4 / Next, std::numeric_limits<std::uint32_t>::max());
+	const std::uint64_t Packed = std::min<std::size_t>(Burst == 0 ? Rate : Burst, static_cast<std::size_t>(MaxBurst));
+
+	Settings.store(static_cast<std::uint64_t>(Next) << 32 | Packed, std::memory_order_release);
+
+	// Debt of a larger Burst would keep the bucket empty for longer than the new one lets
+	const std::int64_t Limit = Now + Next * static_cast<std::int64_t>(Packed);
+	std::int64_t Current = Full.load(std::memory_order_relaxed);
+
+	while (Current > Limit && !Full.compare_exchange_weak(Current, Limit, std::memory_order_relaxed));
+}
+
+void net::token_bucket::set(const std::size_t Rate, const std::size_t Burst)
+{
+	set(Rate, Burst, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+std::size_t net::token_bucket::get_rate(void) const
+{
+	const std::int64_t CachedInterval = interval(Settings.load(std::memory_order_acquire));
+
+	return CachedInterval == 0 ? 0 : static_cast<std::size_t>(Second / CachedInterval);
+}
+
+std::size_t net::token_bucket::get_burst(void) const
+{
+	const std::uint64_t Cached = Settings.load(std::memory_order_acquire);
+
+	return interval(Cached) == 0 ? 0 : static_cast<std::size_t>(burst(Cached));
+}
+
+bool net::token_bucket::limited(void) const
+{
+	return Settings.load(std::memory_order_relaxed) != 0;
+}
+
+std::size_t net::token_bucket::take(const std::size_t Count, const std::int64_t Now)
+{
+	const std::uint64_t Cached = Settings.load(std::memory_order_acquire);
+	const std::int64_t CachedInterval = interval(Cached);
+
+	if (CachedInterval == 0)
+		return Count;
+
+	const std::int64_t CachedTolerance = CachedInterval * burst(Cached);
+	std::int64_t Current = Full.load(std::memory_order_relaxed);
+
+	while (true)
+	{
+		// Bucket which has been full for a while does not save more than Burst
+		const std::int64_t Base = std::max(Current, Now);
+		const std::int64_t Room = Now + CachedTolerance - Base;
+
+		if (Room < CachedInterval)
+			return 0;
+
+		const std::size_t Taken = std::min(Count, static_cast<std::size_t>(Room / CachedInterval));
+
+		if (Full.compare_exchange_weak(Current, Base + static_cast<std::int64_t>(Taken) * CachedInterval, std::memory_order_relaxed))
+			return Taken;
+	}
+}
+
+void net::token_bucket::refund(const std::size_t Count)
+{
+	const std::int64_t CachedInterval = interval(Settings.load(std::memory_order_acquire));
+
+	if (CachedInterval != 0 && Count != 0)
+		Full.fetch_sub(static_cast<std::int64_t>(Count) * CachedInterval, std::memory_order_relaxed);
+}
@@ -0,0 +1,84 @@
+# include <netordering/codel.hpp>
+
+# include <cmath>
+
+net::codel::codel(void) : Target(0), Interval(100000000), FirstAboveTime(0), DropNext(0), Count(0), LastCount(0), Dropping(false)
+{ }
+
+void net::codel::set(const std::int64_t __Target, const std::int64_t __Interval)
+{
+	std::lock_guard<std::mutex> LockGuard(Mutex);
+
+	Target.store(__Target, std::memory_order_relaxed);
+	Interval.store(__Interval, std::memory_order_relaxed);
+	FirstAboveTime = 0;
+	Dropping = false;
+}
+
+std::int64_t net::codel::get_target(void) const
+{
+	return Target.load(std::memory_order_relaxed);
+}
+
+std::int64_t net::codel::get_interval(void) const
+{
+	return Interval.load(std::memory_order_relaxed);
+}
+
+bool net::codel::drop(const std::int64_t Sojourn, const std::int64_t Now, const bool Empty)
+{
+	if (Target.load(std::memory_order_relaxed) == 0)
+		return false;
+
+	std::lock_guard<std::mutex> LockGuard(Mutex);
+	const bool Above = above(Sojourn, Now, Empty);
+	const std::int64_t CachedInterval = Interval.load(std::memory_order_relaxed);
+
+	if (Dropping)
+	{
+		if (!Above)
+		{
+			Dropping = false;
+			return false;
+		}
+		if (Now < DropNext)
+			return false;
+
+		Count += 1;
+		DropNext = control(DropNext);
+		return true;
+	}
+
+	if (!Above)
+		return false;
+
+	// Drops are resumed with the previous rate if the last dropping state was recent
+	const std::uint32_t Delta = Count - LastCount;
+
+	Dropping = true;
+	Count = Delta > 1 && Now - DropNext < 16 * CachedInterval ? Delta : 1;
+	DropNext = control(Now);
+	LastCount = Count;
+
+	return true;
+}
+
+bool net::codel::above(const std::int64_t Sojourn, const std::int64_t Now, const bool Empty)
+{
+	if (Sojourn < Target.load(std::memory_order_relaxed) || Empty)
+	{
+		FirstAboveTime = 0;
+		return false;
+	}
+	if (FirstAboveTime == 0)
+	{
+		FirstAboveTime = Now + Interval.load(std::memory_order_relaxed);
+		return false;
+	}
+	return Now >= FirstAboveTime;
+}
+
+std::int64_t net::codel::control(const std::int64_t Time) const
+{
+	return Time + static_cast<std::int64_t>(static_cast<double>(Interval.load(std::memory_order_relaxed)) / std::sqrt(static_cast<double>(Count)));
+}
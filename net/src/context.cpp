@@ -0,0 +1,76 @@
+# include <netordering/context.hpp>
+
+net::context_pool::context_pool(void) : Next(0), Balance(balance::round_robin)
+{
+	launch(std::max<std::size_t>(std::thread::hardware_concurrency(), 1));
+}
+
+net::context_pool::context_pool(const std::size_t Size) : Next(0), Balance(balance::round_robin)
+{
+	launch(Size == 0 ? std::max<std::size_t>(std::thread::hardware_concurrency(), 1) : Size);
+}
+
+net::context_pool::~context_pool(void)
+{
+	for (auto& Guard : Guards)
+		Guard.reset();
+	for (auto& Slot : Slots)
+		Slot->context.stop();
+
+	for (std::thread& Thread : Threads)
+		if (Thread.joinable())
+			Thread.join();
+}
+
+void net::context_pool::launch(const std::size_t Size)
+{
+	Slots.reserve(Size);
+	Guards.reserve(Size);
+	Threads.reserve(Size);
+
+	for (std::size_t Index = 0; Index < Size; Index += 1)
+	{
+		Slots.push_back(std::make_shared<slot>());
+		Guards.push_back(boost::asio::make_work_guard(Slots.back()->context));
+		Threads.emplace_back([Slot = Slots.back()](void) -> void {
+			Slot->context.run();
+		});
+	}
+}
+
+[[ nodiscard ]]
+std::shared_ptr<net::context_pool::slot> net::context_pool::acquire(void)
+{
+	if (Balance.load(std::memory_order_relaxed) == balance::least_load)
+	{
+		std::size_t Best = 0;
+
+		for (std::size_t Index = 1; Index < Slots.size(); Index += 1)
+			if (Slots[Index]->load.load(std::memory_order_relaxed) < Slots[Best]->load.load(std::memory_order_relaxed))
+				Best = Index;
+		return Slots[Best];
+	}
+	return Slots[Next.fetch_add(1, std::memory_order_relaxed) % Slots.size()];
+}
+
+std::size_t net::context_pool::size(void) const
+{
+	return Slots.size();
+}
+
+void net::context_pool::set_balance(const net::balance __Balance)
+{
+	Balance.store(__Balance, std::memory_order_relaxed);
+}
+
+net::balance net::context_pool::get_balance(void) const
+{
+	return Balance.load(std::memory_order_relaxed);
+}
+
+std::shared_ptr<net::context_pool> net::context_pool::shared(void)
+{
+	static std::shared_ptr<net::context_pool> Pool = std::make_shared<net::context_pool>();
+
+	return Pool;
+}
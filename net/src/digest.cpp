@@ -0,0 +1,290 @@
+# include <netordering/digest.hpp>
+
+# include <stdexcept>
+# include <vector>
+
+# include <openssl/evp.h>
+# include <unistd.h>
+
+# ifdef __SSE2__
+#	include <emmintrin.h>
+# endif
+
+static constexpr std::size_t ContextCacheSize = 8;
+
+/*
+*	Implicit fetch of EVP_sha256() and others looks the algorithm up on every EVP_DigestInit_ex() since OpenSSL 3,
+*	so they are fetched once
+*/
+static EVP_MD const* message_digest(const net::algorithm Algorithm)
+{
+	static const std::array<EVP_MD const*, 4> Digests = [](void) -> std::array<EVP_MD const*, 4> {
+# if OPENSSL_VERSION_NUMBER >= 0x30000000L
+		return { EVP_MD_fetch(nullptr, "MD5", nullptr), EVP_MD_fetch(nullptr, "SHA1", nullptr),
+			EVP_MD_fetch(nullptr, "SHA256", nullptr), EVP_MD_fetch(nullptr, "SHA512", nullptr) };
+# else
+		return { EVP_md5(), EVP_sha1(), EVP_sha256(), EVP_sha512() };
+# endif
+	}();
+
+	EVP_MD const* Result = Digests[static_cast<std::size_t>(Algorithm)];
+
+	if (Result == nullptr)
+		throw std::runtime_error("Digest is not available in OpenSSL");
+	return Result;
+}
+
+struct context_cache final
+{
+	std::vector<EVP_MD_CTX*> Contexts;
+
+	~context_cache(void)
+	{
+		for (EVP_MD_CTX* Context : Contexts)
+			EVP_MD_CTX_free(Context);
+	}
+};
+
+static context_cache& local_context_cache(void)
+{
+	thread_local context_cache Cache;
+
+	return Cache;
+}
+
+static EVP_MD_CTX* take_context(void)
+{
+	std::vector<EVP_MD_CTX*>& Contexts = local_context_cache().Contexts;
+
+	if (Contexts.empty())
+		return EVP_MD_CTX_new();
+
+	EVP_MD_CTX* Result = Contexts.back();
+	Contexts.pop_back();
+	return Result;
+}
+
+static void give_context(EVP_MD_CTX* Context)
+{
+	std::vector<EVP_MD_CTX*>& Contexts = local_context_cache().Contexts;
+
+	// Context which is not reset keeps the state of its digest, it is reused by the next init of the same one
+	if (Contexts.size() < ContextCacheSize)
+		Contexts.push_back(Context);
+	else
+		EVP_MD_CTX_free(Context);
+}
+
+std::size_t net::hex(std::span<const unsigned char> Bytes, char* Out)
+{
+	static constexpr char Digits[] = "0123456789abcdef";
+	std::size_t Index = 0;
+
+# ifdef __SSE2__
+	const __m128i Low = _mm_set1_epi8(0x0f);
+	const __m128i Nine = _mm_set1_epi8(9);
+	const __m128i Zero = _mm_set1_epi8('0');
+	const __m128i Letters = _mm_set1_epi8('a' - '0' - 10);
+
+	for (; Index + 16 <= Bytes.size(); Index += 16)
+	{
+		const __m128i Data = _mm_loadu_si128(reinterpret_cast<__m128i const*>(Bytes.data() + Index));
+		const __m128i High = _mm_and_si128(_mm_srli_epi16(Data, 4), Low);
+		const __m128i Lower = _mm_and_si128(Data, Low);
+
+		// Nibble + '0', and the distance to 'a' for nibbles above 9
+		const __m128i First = _mm_add_epi8(_mm_add_epi8(High, Zero), _mm_and_si128(_mm_cmpgt_epi8(High, Nine), Letters));
+		const __m128i Second = _mm_add_epi8(_mm_add_epi8(Lower, Zero), _mm_and_si128(_mm_cmpgt_epi8(Lower, Nine), Letters));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(Out + 2 * Index), _mm_unpacklo_epi8(First, Second));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(Out + 2 * Index + 16), _mm_unpackhi_epi8(First, Second));
+	}
+# endif
+	for (; Index < Bytes.size(); Index += 1)
+	{
+		Out[2 * Index] = Digits[Bytes[Index] >> 4];
+		Out[2 * Index + 1] = Digits[Bytes[Index] & 0x0f];
+	}
+	return 2 * Bytes.size();
+}
+
+std::string net::digest::hex(void) const
+{
+	std::string Result(2 * size, '\0');
+
+	net::hex(std::span<const unsigned char>(bytes.data(), size), Result.data());
+	return Result;
+}
+
+std::string net::digest::etag(void) const
+{
+	std::string Result(2 * size + 2, '"');
+
+	net::hex(std::span<const unsigned char>(bytes.data(), size), Result.data() + 1);
+	return Result;
+}
+
+bool net::digest::matches(std::string_view IfNoneMatch) const
+{
+	std::array<char, 2 * MaxSize> Hex;
+	const std::string_view Own(Hex.data(), net::hex(std::span<const unsigned char>(bytes.data(), size), Hex.data()));
+
+	while (!IfNoneMatch.empty())
+	{
+		const std::size_t Comma = std::min(IfNoneMatch.find(','), IfNoneMatch.size());
+		std::string_view Tag = IfNoneMatch.substr(0, Comma);
+
+		while (!Tag.empty() && (Tag.front() == ' ' || Tag.front() == '\t'))
+			Tag.remove_prefix(1);
+		while (!Tag.empty() && (Tag.back() == ' ' || Tag.back() == '\t'))
+			Tag.remove_suffix(1);
+		if (Tag == "*")
+			return true;
+		// If-None-Match uses weak comparison(RFC 9110 13.1.2)
+		if (Tag.starts_with("W/"))
+			Tag.remove_prefix(2);
+		if (Tag.size() == Own.size() + 2 && Tag.front() == '"' && Tag.back() == '"' && Tag.substr(1, Own.size()) == Own)
+			return true;
+		IfNoneMatch.remove_prefix(std::min(Comma + 1, IfNoneMatch.size()));
+	}
+	return false;
+}
+
+net::hasher::hasher(const net::algorithm __Algorithm) : Context(take_context()), Algorithm(__Algorithm)
+{
+	if (Context == nullptr || EVP_DigestInit_ex(static_cast<EVP_MD_CTX*>(Context), message_digest(Algorithm), nullptr) != 1)
+	{
+		if (Context != nullptr)
+			give_context(static_cast<EVP_MD_CTX*>(Context));
+		throw std::runtime_error("Can not initialize digest");
+	}
+}
+
+net::hasher::~hasher(void)
+{
+	give_context(static_cast<EVP_MD_CTX*>(Context));
+}
+
+net::hasher& net::hasher::update(const std::string_view Data)
+{
+	EVP_DigestUpdate(static_cast<EVP_MD_CTX*>(Context), Data.data(), Data.size());
+	return *this;
+}
+
+net::hasher& net::hasher::update(net::buffer const& Buffer)
+{
+	return update(Buffer.view());
+}
+
+net::hasher& net::hasher::update(std::initializer_list<std::string_view> Parts)
+{
+	return update(std::span<const std::string_view>(Parts.begin(), Parts.size()));
+}
+
+net::hasher& net::hasher::update(std::span<const std::string_view> Parts)
+{
+	for (const std::string_view Part : Parts)
+		update(Part);
+	return *this;
+}
+
+net::hasher& net::hasher::update(net::file const& File)
+{
+	net::buffer Buffer;
+	std::size_t Offset = 0;
+
+	while (Offset < File.size())
+	{
+		const ssize_t Count = ::pread(File.descriptor(), Buffer.data(), std::min(Buffer.capacity(), File.size() - Offset), static_cast<off_t>(Offset));
+
+		if (Count < 0 && errno == EINTR)
+			continue;
+		if (Count <= 0)
+			throw std::runtime_error("Can not read file for digest");
+		update(std::string_view(Buffer.data(), static_cast<std::size_t>(Count)));
+		Offset += static_cast<std::size_t>(Count);
+	}
+	return *this;
+}
+
+net::digest net::hasher::finish(void)
+{
+	EVP_MD_CTX* Local = static_cast<EVP_MD_CTX*>(Context);
+	net::digest Result;
+	unsigned int Size = 0;
+
+	EVP_DigestFinal_ex(Local, Result.bytes.data(), &Size);
+	EVP_DigestInit_ex(Local, message_digest(Algorithm), nullptr);
+	Result.size = Size;
+	return Result;
+}
+
+net::digest net::hash(const net::algorithm Algorithm, const std::string_view Data)
+{
+	return net::hasher(Algorithm).update(Data).finish();
+}
+
+void net::hash(const net::algorithm Algorithm, std::span<const std::string_view> Payloads, std::span<net::digest> Results)
+{
+	if (Results.size() < Payloads.size())
+		throw std::invalid_argument("Results are shorter than payloads");
+
+	net::hasher Hasher(Algorithm);
+
+	for (std::size_t Index = 0; Index < Payloads.size(); Index += 1)
+		Results[Index] = Hasher.update(Payloads[Index]).finish();
+}
+
+net::response_cache::response_cache(const std::size_t __Capacity) : Capacity(__Capacity)
+{ }
+
+std::shared_ptr<const std::string> net::response_cache::find(net::digest const& Key)
+{
+	std::lock_guard<std::mutex> LockGuard(Mutex);
+	std::unordered_map<net::digest, std::list<cached>::iterator, net::digest_hash>::iterator Iterator = Index.find(Key);
+
+	if (Iterator == Index.end())
+		return nullptr;
+
+	Order.splice(Order.begin(), Order, Iterator->second);
+	return Iterator->second->Response;
+}
+
+std::shared_ptr<const std::string> net::response_cache::insert(net::digest const& Key, std::string Response)
+{
+	std::shared_ptr<const std::string> Result = std::make_shared<const std::string>(std::move(Response));
+	std::lock_guard<std::mutex> LockGuard(Mutex);
+
+	if (Capacity == 0)
+		return Result;
+	if (std::unordered_map<net::digest, std::list<cached>::iterator, net::digest_hash>::iterator Iterator = Index.find(Key); Iterator != Index.end())
+	{
+		Iterator->second->Response = Result;
+		Order.splice(Order.begin(), Order, Iterator->second);
+		return Result;
+	}
+
+	Order.push_front(cached{ Key, Result });
+	Index.emplace(Key, Order.begin());
+	while (Order.size() > Capacity)
+	{
+		Index.erase(Order.back().Key);
+		Order.pop_back();
+	}
+	return Result;
+}
+
+std::size_t net::response_cache::size(void)
+{
+	std::lock_guard<std::mutex> LockGuard(Mutex);
+
+	return Order.size();
+}
+
+void net::response_cache::clear(void)
+{
+	std::lock_guard<std::mutex> LockGuard(Mutex);
+
+	Index.clear();
+	Order.clear();
+}
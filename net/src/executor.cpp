@@ -0,0 +1,143 @@
+# include <netordering/net.hpp>
+
+net::executor::executor(std::function<void(std::unique_ptr<connection>)> __Handler, const std::size_t __Size)
+	: Stopping(false), Next(0), Busy(0), Size(0), Handler(std::move(__Handler))
+{
+	resize(__Size);
+}
+
+net::executor::~executor(void)
+{
+	Stopping.store(true, std::memory_order_seq_cst);
+	Work.notify_all();
+	Released.notify_all();
+
+	for (auto& Worker : Workers)
+		if (Worker->Thread.joinable())
+			Worker->Thread.join();
+}
+
+void net::executor::submit(std::unique_ptr<net::connection> Connection)
+{
+	Busy.fetch_add(1, std::memory_order_acq_rel);
+	{
+		std::shared_lock<std::shared_mutex> WorkersLock(WorkersMutex);
+		worker& Worker = *Workers[Next.fetch_add(1, std::memory_order_relaxed) % Size.load(std::memory_order_acquire)];
+
+		std::lock_guard<std::mutex> LockGuard(Worker.Mutex);
+		Worker.Deque.push_back(std::move(Connection));
+	}
+	Work.notify_one();
+}
+
+void net::executor::resize(std::size_t __Size)
+{
+	if (__Size == 0)
+		__Size = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+
+	{
+		std::unique_lock<std::shared_mutex> WorkersLock(WorkersMutex);
+
+		Size.store(__Size, std::memory_order_seq_cst);
+		while (Workers.size() < __Size)
+			Workers.push_back(std::make_unique<worker>());
+
+		for (std::size_t Index = 0; Index < __Size; Index += 1)
+			if (Workers[Index]->Retired)
+			{
+				if (Workers[Index]->Thread.joinable())
+					Workers[Index]->Thread.join();
+
+				Workers[Index]->Retired = false;
+				Workers[Index]->Thread = std::thread(&net::executor::work, this, Index);
+			}
+	}
+	Work.notify_all();
+	Released.notify_all();
+}
+
+std::size_t net::executor::size(void) const
+{
+	return Size.load(std::memory_order_relaxed);
+}
+
+std::size_t net::executor::busy(void) const
+{
+	return Busy.load(std::memory_order_relaxed);
+}
+
+std::size_t net::executor::available(void) const
+{
+	const std::size_t CachedSize = Size.load(std::memory_order_acquire);
+	const std::size_t CachedBusy = Busy.load(std::memory_order_acquire);
+
+	return CachedBusy < CachedSize ? CachedSize - CachedBusy : 0;
+}
+
+void net::executor::interrupt(void)
+{
+	Released.notify_all();
+}
+
+std::unique_ptr<net::connection> net::executor::take(const std::size_t Index)
+{
+	std::shared_lock<std::shared_mutex> WorkersLock(WorkersMutex);
+
+	for (std::size_t Offset = 0; Offset < Workers.size(); Offset += 1)
+	{
+		worker& Worker = *Workers[(Index + Offset) % Workers.size()];
+		std::lock_guard<std::mutex> LockGuard(Worker.Mutex);
+
+		if (!Worker.Deque.empty())
+		{
+			std::unique_ptr<net::connection> Result = std::move(Worker.Deque.front());
+
+			Worker.Deque.pop_front();
+			return Result;
+		}
+	}
+	return nullptr;
+}
+
+void net::executor::work(const std::size_t Index)
+{
+	std::function<void(std::unique_ptr<net::connection>)> CachedHandler = Handler;
+
+	while (true)
+	{
+		const std::size_t Epoch = Work.epoch();
+		std::unique_ptr<net::connection> Connection = take(Index);
+
+		if (Connection != nullptr)
+		{
+			try
+			{
+				CachedHandler(std::move(Connection));
+			}
+			catch (...)
+			{ }
+
+			if (Busy.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				Idle.notify_all();
+			Released.notify_one();
+			continue;
+		}
+
+		if (Stopping.load(std::memory_order_acquire))
+			return;
+
+		{
+			std::unique_lock<std::shared_mutex> WorkersLock(WorkersMutex);
+
+			if (Index >= Size.load(std::memory_order_acquire))
+			{
+				Workers[Index]->Retired = true;
+				return;
+			}
+		}
+
+		Work.wait([&](void) -> bool {
+			return Work.epoch() != Epoch || Stopping.load(std::memory_order_acquire) || Index >= Size.load(std::memory_order_acquire);
+		});
+	}
+}
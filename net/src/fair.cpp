@@ -0,0 +1,270 @@
+# include <netordering/fair.hpp>
+# include <netordering/payload.hpp>
+
+# include <algorithm>
+# include <random>
+# include <cstring>
+# include <array>
+
+# include <sys/socket.h>
+# include <netinet/in.h>
+# include <arpa/inet.h>
+# include <unistd.h>
+
+/*
+*	Finalizer of splitmix64, every bit of Value changes about half of the result
+*/
+static std::uint64_t mix(std::uint64_t Value)
+{
+	Value ^= Value >> 30;
+	Value *= 0xbf58476d1ce4e5b9ULL;
+	Value ^= Value >> 27;
+	Value *= 0x94d049bb133111ebULL;
+	Value ^= Value >> 31;
+	return Value;
+}
+
+net::fair_queue::fair_queue(void) : Free(Nil), Buckets(1), Size(0), Count(0), Cap(0), Salt(0), Generation(0)
+{ }
+
+net::fair_queue::~fair_queue(void)
+{
+	for (bucket& Bucket : Buckets)
+		for (std::uint32_t Index = Bucket.Head; Index != Nil; Index = Nodes[Index].Next)
+		{
+			::close(Nodes[Index].Entry.descriptor);
+			net::buffer::recycle(Nodes[Index].Entry.prefetched);
+		}
+}
+
+void net::fair_queue::configure(const std::size_t __Count, const std::size_t __Cap)
+{
+	std::lock_guard<std::mutex> LockGuard(Mutex);
+	std::vector<net::entry> Queued;
+
+	Queued.reserve(Size.load(std::memory_order_relaxed));
+	for (std::uint32_t Index = 0; Index < Buckets.size(); Index += 1)
+		while (Buckets[Index].Length != 0)
+			Queued.push_back(take(Index));
+
+	// Disabled order keeps one bucket, so clients which are left are still popped
+	Buckets.assign(std::max<std::size_t>(__Count, 1), bucket());
+	Round.clear();
+	Cap = __Cap;
+	Salt = (static_cast<std::uint64_t>(std::random_device()()) << 32) ^ std::random_device()();
+	Generation += 1;
+	Count.store(__Count, std::memory_order_release);
+
+	for (net::entry& Entry : Queued)
+		append(index(Entry), Entry);
+}
+
+bool net::fair_queue::enabled(void) const
+{
+	return Count.load(std::memory_order_acquire) != 0;
+}
+
+std::size_t net::fair_queue::buckets(void) const
+{
+	return Count.load(std::memory_order_relaxed);
+}
+
+std::size_t net::fair_queue::get_cap(void) const
+{
+	std::lock_guard<std::mutex> LockGuard(const_cast<std::mutex&>(Mutex));
+
+	return Cap;
+}
+
+std::size_t net::fair_queue::push(std::vector<net::entry>& Batch, const std::size_t Limit)
+{
+	std::lock_guard<std::mutex> LockGuard(Mutex);
+	std::vector<net::entry> Rejected;
+	std::size_t Accepted = 0;
+
+	for (std::size_t Index = 0; Index < Batch.size(); Index += 1)
+	{
+		net::entry Entry = Batch[Index];
+		const std::uint32_t Target = index(Entry);
+
+		if (Cap != 0 && Buckets[Target].Active >= Cap)
+		{
+			Rejected.push_back(Entry);
+			continue;
+		}
+		if (Limit != 0 && Size.load(std::memory_order_relaxed) >= Limit)
+		{
+			const std::uint32_t Longest = longest();
+
+			// Client does not push out one of a bucket which would be as long as its own after it
+			if (Longest == Nil || Buckets[Longest].Length <= Buckets[Target].Length + 1)
+			{
+				Rejected.push_back(Entry);
+				continue;
+			}
+			Rejected.push_back(take(Longest));
+			Buckets[Longest].Active -= 1;
+		}
+
+		append(Target, Entry);
+		Batch[Accepted] = Entry;
+		Accepted += 1;
+	}
+
+	Batch.resize(Accepted);
+	Batch.insert(Batch.end(), Rejected.begin(), Rejected.end());
+	return Accepted;
+}
+
+std::optional<net::entry> net::fair_queue::pop(net::fair_queue::ticket& Ticket)
+{
+	std::lock_guard<std::mutex> LockGuard(Mutex);
+
+	while (!Round.empty())
+	{
+		const std::uint32_t Index = Round.front();
+		bucket& Bucket = Buckets[Index];
+
+		Round.pop_front();
+		// Bucket which has been emptied by push-out is left in the round until its turn
+		if (Bucket.Length == 0)
+		{
+			Bucket.Listed = false;
+			continue;
+		}
+
+		net::entry Result = take(Index);
+
+		if (Bucket.Length != 0)
+			Round.push_back(Index);
+		else
+			Bucket.Listed = false;
+
+		Ticket.bucket = Index;
+		Ticket.generation = Generation;
+		return Result;
+	}
+	return std::nullopt;
+}
+
+void net::fair_queue::release(net::fair_queue::ticket const& Ticket)
+{
+	if (Ticket.bucket == Nil)
+		return;
+
+	std::lock_guard<std::mutex> LockGuard(Mutex);
+
+	if (Ticket.generation == Generation && Ticket.bucket < Buckets.size() && Buckets[Ticket.bucket].Active != 0)
+		Buckets[Ticket.bucket].Active -= 1;
+}
+
+std::size_t net::fair_queue::size(void) const
+{
+	return Size.load(std::memory_order_relaxed);
+}
+
+std::uint32_t net::fair_queue::index(net::entry& Entry) const
+{
+	if (Buckets.size() == 1)
+		return 0;
+
+	std::uint64_t Source = 0;
+
+	// Multishot accept of io_uring gives no address, it is asked once here
+	if (Entry.uring && Entry.peer_port == 0)
+	{
+		sockaddr_storage Peer = { };
+		socklen_t Size = sizeof(Peer);
+
+		if (::getpeername(Entry.descriptor, reinterpret_cast<sockaddr*>(&Peer), &Size) == 0)
+		{
+			if (Peer.ss_family == AF_INET6)
+			{
+				sockaddr_in6 const& Address = reinterpret_cast<sockaddr_in6 const&>(Peer);
+
+				Entry.peer_port = ntohs(Address.sin6_port);
+				std::memcpy(Entry.peer_address.data(), &Address.sin6_addr, 16);
+			}
+			else if (Peer.ss_family == AF_INET)
+			{
+				sockaddr_in const& Address = reinterpret_cast<sockaddr_in const&>(Peer);
+
+				Entry.peer_port = ntohs(Address.sin_port);
+				std::memcpy(Entry.peer_address.data(), &Address.sin_addr, 4);
+			}
+		}
+	}
+
+	static constexpr std::array<std::uint8_t, 12> Mapped = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff };
+	std::uint8_t const* Address = Entry.peer_address.data();
+	std::uint8_t Family = Entry.family;
+
+	// Dual-stack listener gives IPv4 clients as ::ffff:a.b.c.d, their /64 is the same for all of them
+	if (Family == 6 && std::memcmp(Address, Mapped.data(), Mapped.size()) == 0)
+	{
+		Address += Mapped.size();
+		Family = 4;
+	}
+
+	// One IPv6 host usually has the whole /64
+	std::memcpy(&Source, Address, Family == 6 ? 8 : 4);
+	return static_cast<std::uint32_t>(mix(Source ^ Salt ^ (static_cast<std::uint64_t>(Family) << 56)) % Buckets.size());
+}
+
+void net::fair_queue::append(const std::uint32_t Index, net::entry const& Entry)
+{
+	std::uint32_t Node = Free;
+
+	if (Node != Nil)
+		Free = Nodes[Node].Next;
+	else
+	{
+		Node = static_cast<std::uint32_t>(Nodes.size());
+		Nodes.push_back(node());
+	}
+	Nodes[Node].Entry = Entry;
+	Nodes[Node].Next = Nil;
+
+	bucket& Bucket = Buckets[Index];
+
+	if (Bucket.Tail == Nil)
+		Bucket.Head = Node;
+	else
+		Nodes[Bucket.Tail].Next = Node;
+	Bucket.Tail = Node;
+	Bucket.Length += 1;
+	Bucket.Active += 1;
+	Size.fetch_add(1, std::memory_order_relaxed);
+
+	if (!Bucket.Listed)
+	{
+		Bucket.Listed = true;
+		Round.push_back(Index);
+	}
+}
+
+net::entry net::fair_queue::take(const std::uint32_t Index)
+{
+	bucket& Bucket = Buckets[Index];
+	const std::uint32_t Node = Bucket.Head;
+
+	Bucket.Head = Nodes[Node].Next;
+	if (Bucket.Head == Nil)
+		Bucket.Tail = Nil;
+	Bucket.Length -= 1;
+	Size.fetch_sub(1, std::memory_order_relaxed);
+
+	Nodes[Node].Next = Free;
+	Free = Node;
+	return Nodes[Node].Entry;
+}
+
+std::uint32_t net::fair_queue::longest(void) const
+{
+	std::uint32_t Result = Nil;
+
+	for (const std::uint32_t Index : Round)
+		if (Buckets[Index].Length != 0 && (Result == Nil || Buckets[Index].Length > Buckets[Result].Length))
+			Result = Index;
+	return Result;
+}
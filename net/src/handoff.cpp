@@ -0,0 +1,339 @@
+# include <netordering/net.hpp>
+
+# include <system_error>
+# include <algorithm>
+# include <cstdlib>
+# include <cstring>
+# include <thread>
+
+# include <sys/socket.h>
+# include <sys/un.h>
+# include <netinet/in.h>
+# include <unistd.h>
+# include <fcntl.h>
+# include <poll.h>
+
+// Descriptors per message, SCM_MAX_FD of Linux is 253
+static constexpr std::size_t HandoffBatch = 64;
+
+static sockaddr_un handoff_address(std::string const& Path)
+{
+	sockaddr_un Result = { };
+
+	if (Path.size() >= sizeof(Result.sun_path))
+		throw std::invalid_argument("Path of Unix socket is too long");
+
+	Result.sun_family = AF_UNIX;
+	std::memcpy(Result.sun_path, Path.c_str(), Path.size() + 1);
+	return Result;
+}
+
+/*
+*	Every message is count of descriptors and descriptors themselves in SCM_RIGHTS, empty message ends the list.
+*	SOCK_SEQPACKET keeps messages apart, so descriptors of two messages are never merged
+*/
+static bool send_descriptors(const int Channel, std::vector<int> const& Descriptors)
+{
+	std::size_t Offset = 0;
+
+	while (true)
+	{
+		const std::uint32_t Count = static_cast<std::uint32_t>(std::min(HandoffBatch, Descriptors.size() - Offset));
+		alignas(cmsghdr) char Control[CMSG_SPACE(sizeof(int) * HandoffBatch)] = { };
+		iovec Vector = { const_cast<std::uint32_t*>(&Count), sizeof(Count) };
+		msghdr Message = { };
+
+		Message.msg_iov = &Vector;
+		Message.msg_iovlen = 1;
+		if (Count != 0)
+		{
+			Message.msg_control = Control;
+			Message.msg_controllen = CMSG_SPACE(sizeof(int) * Count);
+
+			cmsghdr* Header = CMSG_FIRSTHDR(&Message);
+			Header->cmsg_level = SOL_SOCKET;
+			Header->cmsg_type = SCM_RIGHTS;
+			Header->cmsg_len = CMSG_LEN(sizeof(int) * Count);
+			std::memcpy(CMSG_DATA(Header), Descriptors.data() + Offset, sizeof(int) * Count);
+		}
+
+		if (::sendmsg(Channel, &Message, MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(Count)))
+			return false;
+		if (Count == 0)
+			return true;
+		Offset += Count;
+	}
+}
+
+static bool receive_descriptors(const int Channel, net::inherited& Result)
+{
+	while (true)
+	{
+		std::uint32_t Count = 0;
+		alignas(cmsghdr) char Control[CMSG_SPACE(sizeof(int) * HandoffBatch)] = { };
+		iovec Vector = { &Count, sizeof(Count) };
+		msghdr Message = { };
+
+		Message.msg_iov = &Vector;
+		Message.msg_iovlen = 1;
+		Message.msg_control = Control;
+		Message.msg_controllen = sizeof(Control);
+
+		if (::recvmsg(Channel, &Message, MSG_CMSG_CLOEXEC) != static_cast<ssize_t>(sizeof(Count)))
+			return false;
+
+		for (cmsghdr* Header = CMSG_FIRSTHDR(&Message); Header != nullptr; Header = CMSG_NXTHDR(&Message, Header))
+		{
+			if (Header->cmsg_level != SOL_SOCKET || Header->cmsg_type != SCM_RIGHTS)
+				continue;
+
+			const std::size_t Received = (Header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+
+			for (std::size_t Index = 0; Index < Received; Index += 1)
+			{
+				int Descriptor;
+
+				std::memcpy(&Descriptor, CMSG_DATA(Header) + Index * sizeof(int), sizeof(int));
+				if (!Result.add(Descriptor))
+					::close(Descriptor);
+			}
+		}
+		if (Count == 0)
+			return true;
+	}
+}
+
+net::inherited::inherited(net::inherited&& Other) noexcept : Sockets(std::move(Other.Sockets))
+{
+	Other.Sockets.clear();
+}
+
+net::inherited& net::inherited::operator=(net::inherited&& Other) noexcept
+{
+	if (this != &Other)
+	{
+		release();
+		Sockets = std::move(Other.Sockets);
+		Other.Sockets.clear();
+	}
+	return *this;
+}
+
+net::inherited::~inherited(void)
+{
+	release();
+}
+
+bool net::inherited::add(const int Descriptor)
+{
+	int Listening = 0;
+	int Type = 0;
+	socklen_t Size = sizeof(int);
+	sockaddr_storage Address = { };
+	socklen_t AddressSize = sizeof(Address);
+
+	if (::getsockopt(Descriptor, SOL_SOCKET, SO_ACCEPTCONN, &Listening, &Size) != 0 || Listening == 0)
+		return false;
+	Size = sizeof(int);
+	if (::getsockopt(Descriptor, SOL_SOCKET, SO_TYPE, &Type, &Size) != 0 || Type != SOCK_STREAM)
+		return false;
+	if (::getsockname(Descriptor, reinterpret_cast<sockaddr*>(&Address), &AddressSize) != 0)
+		return false;
+
+	std::size_t Port = 0;
+
+	if (Address.ss_family == AF_INET)
+		Port = ntohs(reinterpret_cast<sockaddr_in const&>(Address).sin_port);
+	else if (Address.ss_family == AF_INET6)
+		Port = ntohs(reinterpret_cast<sockaddr_in6 const&>(Address).sin6_port);
+	else
+		return false;
+
+	Sockets[Port].push_back(Descriptor);
+	return true;
+}
+
+std::vector<int> net::inherited::take(const std::size_t Port)
+{
+	std::map<std::size_t, std::vector<int>>::iterator Iterator = Sockets.find(Port);
+
+	if (Iterator == Sockets.end())
+		return { };
+
+	std::vector<int> Result = std::move(Iterator->second);
+	Sockets.erase(Iterator);
+	return Result;
+}
+
+std::vector<std::size_t> net::inherited::ports(void) const
+{
+	std::vector<std::size_t> Result;
+
+	for (auto& [Port, Descriptors] : Sockets)
+		Result.push_back(Port);
+	return Result;
+}
+
+std::size_t net::inherited::size(void) const
+{
+	std::size_t Result = 0;
+
+	for (auto& [Port, Descriptors] : Sockets)
+		Result += Descriptors.size();
+	return Result;
+}
+
+bool net::inherited::empty(void) const
+{
+	return Sockets.empty();
+}
+
+void net::inherited::release(void)
+{
+	for (auto& [Port, Descriptors] : Sockets)
+		for (const int Descriptor : Descriptors)
+			::close(Descriptor);
+	Sockets.clear();
+}
+
+net::inherited net::inherit(std::string const& Path, const std::chrono::milliseconds Timeout)
+{
+	const sockaddr_un Address = handoff_address(Path);
+	const std::chrono::steady_clock::time_point Deadline = std::chrono::steady_clock::now() + Timeout;
+	net::inherited Result;
+
+	while (true)
+	{
+		const int Channel = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+
+		if (Channel == -1)
+			throw std::system_error(errno, std::generic_category(), "socket");
+
+		if (::connect(Channel, reinterpret_cast<sockaddr const*>(&Address), sizeof(Address)) == 0)
+		{
+			// Old process disables its listeners only after the acknowledgement
+			if (receive_descriptors(Channel, Result))
+			{
+				const char Acknowledgement = 1;
+
+				::send(Channel, &Acknowledgement, 1, MSG_NOSIGNAL);
+			}
+			else
+				Result = net::inherited();
+			::close(Channel);
+			return Result;
+		}
+		::close(Channel);
+
+		// Old process has not come to hand_over() yet
+		if (std::chrono::steady_clock::now() >= Deadline)
+			return Result;
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+}
+
+net::inherited net::inherit_systemd(void)
+{
+	static constexpr int First = 3;
+	net::inherited Result;
+	char const* Pid = std::getenv("LISTEN_PID");
+	char const* Count = std::getenv("LISTEN_FDS");
+
+	if (Pid == nullptr || Count == nullptr || std::strtol(Pid, nullptr, 10) != static_cast<long>(::getpid()))
+		return Result;
+
+	const int Total = static_cast<int>(std::strtol(Count, nullptr, 10));
+
+	::unsetenv("LISTEN_PID");
+	::unsetenv("LISTEN_FDS");
+	::unsetenv("LISTEN_FDNAMES");
+
+	for (int Descriptor = First; Descriptor < First + Total; Descriptor += 1)
+	{
+		// Descriptors which are not TCP listeners are left to the application
+		if (Result.add(Descriptor))
+			::fcntl(Descriptor, F_SETFD, FD_CLOEXEC);
+	}
+	return Result;
+}
+
+void net::queue::inherit(net::inherited&& Sockets)
+{
+	std::lock_guard<std::mutex> ThreadSafetyLockGuard(ThreadSafety);
+
+	{
+		std::lock_guard<std::mutex> ListenersProtectorLockGuard(ListenersProtector);
+
+		for (const std::size_t Port : Sockets.ports())
+		{
+			if (std::any_of(Listeners.begin(), Listeners.end(), [Port](std::shared_ptr<listener> const& Listener) -> bool { return Listener->get_port() == Port; }))
+				continue;
+
+			Listeners.push_back(std::make_shared<listener>(Port, Sockets.take(Port), AcceptorsCount.load(std::memory_order_acquire)));
+			Listeners.back()->observe(&Arrivals);
+			Listeners.back()->set_accept_batch(AcceptBatch.load(std::memory_order_acquire));
+			adopt(*Listeners.back());
+		}
+		ListenersVersion.fetch_add(1, std::memory_order_release);
+		Arrivals.notify_all();
+	}
+	update();
+}
+
+std::size_t net::queue::hand_over(std::string const& Path, const std::chrono::milliseconds Timeout)
+{
+	const sockaddr_un Address = handoff_address(Path);
+	const int Server = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+
+	if (Server == -1)
+		throw std::system_error(errno, std::generic_category(), "socket");
+
+	::unlink(Path.c_str());
+	if (::bind(Server, reinterpret_cast<sockaddr const*>(&Address), sizeof(Address)) != 0 || ::listen(Server, 1) != 0)
+	{
+		const int Error = errno;
+
+		::close(Server);
+		throw std::system_error(Error, std::generic_category(), "bind " + Path);
+	}
+
+	pollfd Waiting = { Server, POLLIN, 0 };
+	int Channel = -1;
+
+	if (::poll(&Waiting, 1, static_cast<int>(Timeout.count())) == 1)
+		Channel = ::accept4(Server, nullptr, nullptr, SOCK_CLOEXEC);
+	::close(Server);
+	::unlink(Path.c_str());
+
+	if (Channel == -1)
+		return 0;
+
+	std::vector<int> Descriptors;
+
+	{
+		std::lock_guard<std::mutex> ListenersProtectorLockGuard(ListenersProtector);
+
+		for (auto& Listener : Listeners)
+		{
+			std::vector<int> Own = Listener->descriptors();
+
+			Descriptors.insert(Descriptors.end(), Own.begin(), Own.end());
+		}
+	}
+
+	char Acknowledgement = 0;
+	pollfd Answer = { Channel, POLLIN, 0 };
+	const bool Passed = send_descriptors(Channel, Descriptors)
+		&& ::poll(&Answer, 1, static_cast<int>(Timeout.count())) == 1 && ::recv(Channel, &Acknowledgement, 1, 0) == 1;
+
+	::close(Channel);
+	for (const int Descriptor : Descriptors)
+		::close(Descriptor);
+
+	if (!Passed)
+		return 0;
+
+	// Sockets are shared with the new process now, clients in their backlog are accepted there
+	disable();
+	return Descriptors.size();
+}
@@ -0,0 +1,64 @@
+# include <netordering/http.hpp>
+
+# include <cstring>
+
+static constexpr std::string_view BadRequest = "HTTP/1.1 400 Bad Request\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+static constexpr std::string_view ContentTooLarge = "HTTP/1.1 413 Content Too Large\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+static constexpr std::string_view FieldsTooLarge = "HTTP/1.1 431 Request Header Fields Too Large\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+static constexpr std::string_view NotImplemented = "HTTP/1.1 501 Not Implemented\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+
+void net::frame(std::unique_ptr<net::connection> Connection, std::function<bool(net::connection&, net::request_view const&)> const& Handler)
+{
+	boost::system::error_code Error;
+	net::buffer Buffer = Connection->read(Error);
+	net::request_view Request;
+	std::size_t Offset = 0;
+
+	while (!Error)
+	{
+		switch (net::parse(Buffer.view().substr(Offset), Request))
+		{
+			case net::framing::complete:
+				Offset += Request.size;
+				if (!Handler(*Connection, Request))
+					return;
+				// Connection waits for the next request without a worker
+				if (Offset == Buffer.size())
+				{
+					net::park(std::move(Connection));
+					return;
+				}
+				break;
+			case net::framing::partial:
+				// Unfinished request is moved to the front, the rest of it is read after
+				if (Offset != 0)
+				{
+					std::memmove(Buffer.data(), Buffer.data() + Offset, Buffer.size() - Offset);
+					Buffer.resize(Buffer.size() - Offset);
+					Offset = 0;
+				}
+				// Size is known once the header section is complete, so too large body is answered before it is read
+				if (Request.size > Buffer.capacity())
+				{
+					Connection->write({ ContentTooLarge }, Error);
+					return;
+				}
+				if (Buffer.size() == Buffer.capacity())
+				{
+					Connection->write({ FieldsTooLarge }, Error);
+					return;
+				}
+				Connection->read(Buffer, Error);
+				break;
+			case net::framing::invalid:
+				Connection->write({ BadRequest }, Error);
+				return;
+			case net::framing::too_large:
+				Connection->write({ FieldsTooLarge }, Error);
+				return;
+			case net::framing::unsupported:
+				Connection->write({ NotImplemented }, Error);
+				return;
+		}
+	}
+}
@@ -0,0 +1,199 @@
+# include <netordering/metrics.hpp>
+
+# include <algorithm>
+# include <cstdio>
+# include <bit>
+
+net::histogram::histogram(void) : Count(0), Sum(0), Max(0)
+{
+	for (std::atomic<std::uint64_t>& Bucket : Counts)
+		Bucket.store(0, std::memory_order_relaxed);
+}
+
+void net::histogram::record(const std::uint64_t Value)
+{
+	Counts[index(Value)].fetch_add(1, std::memory_order_relaxed);
+	Count.fetch_add(1, std::memory_order_relaxed);
+	Sum.fetch_add(Value, std::memory_order_relaxed);
+
+	std::uint64_t CachedMax = Max.load(std::memory_order_relaxed);
+	while (Value > CachedMax && !Max.compare_exchange_weak(CachedMax, Value, std::memory_order_relaxed))
+		continue;
+}
+
+net::histogram_snapshot net::histogram::snapshot(void) const
+{
+	histogram_snapshot Result;
+
+	Result.buckets.resize(Buckets);
+	for (std::size_t Index = 0; Index < Buckets; Index += 1)
+	{
+		Result.buckets[Index] = Counts[Index].load(std::memory_order_relaxed);
+		Result.count += Result.buckets[Index];
+	}
+	Result.sum = Sum.load(std::memory_order_relaxed);
+	Result.max = Max.load(std::memory_order_relaxed);
+
+	return Result;
+}
+
+std::size_t net::histogram::index(const std::uint64_t Value)
+{
+	if (Value < Sub)
+		return static_cast<std::size_t>(Value);
+
+	const std::size_t Exponent = std::bit_width(Value) - 1;
+	const std::size_t Mantissa = static_cast<std::size_t>(Value >> (Exponent - SubBits)) & (Sub - 1);
+
+	return (Exponent - SubBits + 1) * Sub + Mantissa;
+}
+
+std::uint64_t net::histogram::upper(const std::size_t Index)
+{
+	if (Index < Sub)
+		return Index;
+
+	const std::size_t Exponent = Index / Sub + SubBits - 1;
+	const std::uint64_t Lower = (Sub + Index % Sub) << (Exponent - SubBits);
+
+	return Lower + (std::uint64_t(1) << (Exponent - SubBits)) - 1;
+}
+
+std::uint64_t net::histogram_snapshot::percentile(const double Quantile) const
+{
+	if (count == 0)
+		return 0;
+
+	const std::uint64_t Rank = std::max<std::uint64_t>(static_cast<std::uint64_t>(Quantile * static_cast<double>(count) + 0.5), 1);
+	std::uint64_t Seen = 0;
+
+	for (std::size_t Index = 0; Index < buckets.size(); Index += 1)
+	{
+		Seen += buckets[Index];
+		if (Seen >= Rank)
+			return std::min(net::histogram::upper(Index), max);
+	}
+	return max;
+}
+
+std::uint64_t net::histogram_snapshot::below(const std::uint64_t Bound) const
+{
+	std::uint64_t Result = 0;
+
+	for (std::size_t Index = 0; Index < buckets.size() && net::histogram::upper(Index) < Bound; Index += 1)
+		Result += buckets[Index];
+	return Result;
+}
+
+static void merge_histogram(net::histogram_snapshot& Into, net::histogram_snapshot const& From)
+{
+	Into.count += From.count;
+	Into.sum += From.sum;
+	Into.max = std::max(Into.max, From.max);
+
+	Into.buckets.resize(std::max(Into.buckets.size(), From.buckets.size()), 0);
+	for (std::size_t Index = 0; Index < From.buckets.size(); Index += 1)
+		Into.buckets[Index] += From.buckets[Index];
+}
+
+void net::merge(net::metrics& Into, net::metrics const& From)
+{
+	for (net::port_metrics const& Port : From.ports)
+	{
+		std::vector<net::port_metrics>::iterator Iterator = std::find_if(Into.ports.begin(), Into.ports.end(),
+			[&](net::port_metrics const& Other) -> bool { return Other.port == Port.port; });
+
+		if (Iterator == Into.ports.end())
+		{
+			Into.ports.push_back(Port);
+			continue;
+		}
+		Iterator->accepted += Port.accepted;
+		for (std::size_t Index = 0; Index < Port.rejected.size(); Index += 1)
+			Iterator->rejected[Index] += Port.rejected[Index];
+		Iterator->depth += Port.depth;
+		Iterator->limit += Port.limit;
+	}
+
+	Into.depth += From.depth;
+	Into.limit += From.limit;
+	Into.busy += From.busy;
+	Into.executors += From.executors;
+	Into.parked += From.parked;
+	Into.expired += From.expired;
+	Into.dropped += From.dropped;
+	merge_histogram(Into.queue_wait, From.queue_wait);
+	merge_histogram(Into.handler, From.handler);
+}
+
+static std::string seconds(const std::uint64_t Nanoseconds)
+{
+	char Buffer[32];
+
+	std::snprintf(Buffer, sizeof(Buffer), "%.9g", static_cast<double>(Nanoseconds) / 1e9);
+	return Buffer;
+}
+
+static void histogram_text(std::string& Result, const std::string_view Name, net::histogram_snapshot const& Histogram)
+{
+	// Bounds are powers of four from ~1us to ~69s, they are edges of histogram buckets
+	Result += "# TYPE ";
+	Result += Name;
+	Result += " histogram\n";
+
+	for (std::size_t Power = 10; Power <= 36; Power += 2)
+	{
+		const std::uint64_t Bound = std::uint64_t(1) << Power;
+
+		Result += Name;
+		Result += "_bucket{le=\"" + seconds(Bound) + "\"} ";
+		Result += std::to_string(Histogram.below(Bound)) + "\n";
+	}
+	Result += Name;
+	Result += "_bucket{le=\"+Inf\"} " + std::to_string(Histogram.count) + "\n";
+	Result += Name;
+	Result += "_sum " + seconds(Histogram.sum) + "\n";
+	Result += Name;
+	Result += "_count " + std::to_string(Histogram.count) + "\n";
+}
+
+std::string net::prometheus(net::metrics const& Metrics, const std::string_view Prefix)
+{
+	static constexpr std::string_view Reasons[] = { "limit", "order", "overflow", "rate" };
+
+	const std::string Name(Prefix);
+	std::string Result;
+
+	Result += "# TYPE " + Name + "_accepted_total counter\n";
+	for (net::port_metrics const& Port : Metrics.ports)
+		Result += Name + "_accepted_total{port=\"" + std::to_string(Port.port) + "\"} " + std::to_string(Port.accepted) + "\n";
+
+	Result += "# TYPE " + Name + "_rejected_total counter\n";
+	for (net::port_metrics const& Port : Metrics.ports)
+		for (std::size_t Index = 0; Index < Port.rejected.size(); Index += 1)
+			Result += Name + "_rejected_total{port=\"" + std::to_string(Port.port) + "\",reason=\"" + std::string(Reasons[Index]) + "\"} "
+				+ std::to_string(Port.rejected[Index]) + "\n";
+
+	Result += "# TYPE " + Name + "_port_depth gauge\n";
+	for (net::port_metrics const& Port : Metrics.ports)
+		Result += Name + "_port_depth{port=\"" + std::to_string(Port.port) + "\"} " + std::to_string(Port.depth) + "\n";
+
+	Result += "# TYPE " + Name + "_queue_depth gauge\n";
+	Result += Name + "_queue_depth " + std::to_string(Metrics.depth) + "\n";
+	Result += "# TYPE " + Name + "_queue_limit gauge\n";
+	Result += Name + "_queue_limit " + std::to_string(Metrics.limit) + "\n";
+	Result += "# TYPE " + Name + "_dropped_total counter\n";
+	Result += Name + "_dropped_total{reason=\"max_age\"} " + std::to_string(Metrics.expired) + "\n";
+	Result += Name + "_dropped_total{reason=\"codel\"} " + std::to_string(Metrics.dropped) + "\n";
+	Result += "# TYPE " + Name + "_busy gauge\n";
+	Result += Name + "_busy " + std::to_string(Metrics.busy) + "\n";
+	Result += "# TYPE " + Name + "_executors gauge\n";
+	Result += Name + "_executors " + std::to_string(Metrics.executors) + "\n";
+	Result += "# TYPE " + Name + "_parked gauge\n";
+	Result += Name + "_parked " + std::to_string(Metrics.parked) + "\n";
+
+	histogram_text(Result, Name + "_queue_wait_seconds", Metrics.queue_wait);
+	histogram_text(Result, Name + "_handler_seconds", Metrics.handler);
+
+	return Result;
+}
@@ -1,260 +1,2483 @@
 ﻿# include <netordering/net.hpp>
 
+# include <sys/eventfd.h>
+# include <sys/epoll.h>
+# include <sys/sendfile.h>
+# include <sys/socket.h>
+# include <sys/uio.h>
+# include <linux/errqueue.h>
+# include <netinet/in.h>
+# include <netinet/tcp.h>
+# include <arpa/inet.h>
+# include <cstring>
+# include <map>
+# include <unistd.h>
+# include <fcntl.h>
+# include <poll.h>
+
+static net::entry make_entry(const int Descriptor, const std::size_t Port, sockaddr_storage const& Peer)
+{
+	net::entry Result;
+
+	Result.descriptor = Descriptor;
+	Result.port = static_cast<std::uint16_t>(Port);
+	Result.accepted = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+	if (Peer.ss_family == AF_INET6)
+	{
+		sockaddr_in6 const& Address = reinterpret_cast<sockaddr_in6 const&>(Peer);
+
+		Result.family = 6;
+		Result.peer_port = ntohs(Address.sin6_port);
+		std::memcpy(Result.peer_address.data(), &Address.sin6_addr, 16);
+	}
+	else if (Peer.ss_family == AF_INET)
+	{
+		sockaddr_in const& Address = reinterpret_cast<sockaddr_in const&>(Peer);
+
+		Result.family = 4;
+		Result.peer_port = ntohs(Address.sin_port);
+		std::memcpy(Result.peer_address.data(), &Address.sin_addr, 4);
+	}
+	return Result;
+}
+
+/*
+*	Errors of accept which do not go away until some descriptor or memory is freed
+*/
+static bool exhausted(const int Error)
+{
+	return Error == EMFILE || Error == ENFILE || Error == ENOBUFS || Error == ENOMEM;
+}
+
+static net::backend available(const net::backend Kind)
+{
+# ifdef NETORDERING_IO_URING
+	if (Kind == net::backend::io_uring && net::uring::supported())
+		return Kind;
+# endif
+	return net::backend::epoll;
+}
+
+/*
+*	Free-list of memory blocks for net::connection.
+*	Every thread keeps small cache, blocks are moved between threads by halves through the global list,
+*	because connections are usually built in one thread and destroyed in another.
+*/
+static constexpr std::size_t ConnectionCacheSize = 64;
+static constexpr std::size_t ConnectionPoolSize = 4096;
+
+static std::mutex& connection_pool_mutex(void)
+{
+	static std::mutex Mutex;
+
+	return Mutex;
+}
+
+static std::vector<void*>& connection_pool(void)
+{
+	static std::vector<void*> Pool;
+
+	return Pool;
+}
+
+struct connection_cache final
+{
+	std::vector<void*> Blocks;
+
+	~connection_cache(void)
+	{
+		std::lock_guard<std::mutex> LockGuard(connection_pool_mutex());
+
+		for (void* Block : Blocks)
+			if (connection_pool().size() < ConnectionPoolSize)
+				connection_pool().push_back(Block);
+			else
+				::operator delete(Block);
+	}
+};
+
+static connection_cache& local_connection_cache(void)
+{
+	thread_local connection_cache Cache;
+
+	return Cache;
+}
+
+void* net::connection::operator new(const std::size_t Size)
+{
+	if (Size != sizeof(net::connection))
+		return ::operator new(Size);
+
+	std::vector<void*>& Blocks = local_connection_cache().Blocks;
+
+	if (Blocks.empty())
+	{
+		std::lock_guard<std::mutex> LockGuard(connection_pool_mutex());
+		std::vector<void*>& Pool = connection_pool();
+
+		while (!Pool.empty() && Blocks.size() < ConnectionCacheSize / 2)
+		{
+			Blocks.push_back(Pool.back());
+			Pool.pop_back();
+		}
+	}
+
+	if (Blocks.empty())
+		return ::operator new(Size);
+
+	void* Result = Blocks.back();
+	Blocks.pop_back();
+	return Result;
+}
+
+void net::connection::operator delete(void* Pointer, const std::size_t Size)
+{
+	if (Size != sizeof(net::connection))
+	{
+		::operator delete(Pointer);
+		return;
+	}
+
+	std::vector<void*>& Blocks = local_connection_cache().Blocks;
+
+	Blocks.push_back(Pointer);
+	if (Blocks.size() > ConnectionCacheSize)
+	{
+		std::lock_guard<std::mutex> LockGuard(connection_pool_mutex());
+		std::vector<void*>& Pool = connection_pool();
+
+		while (Blocks.size() > ConnectionCacheSize / 2)
+		{
+			if (Pool.size() < ConnectionPoolSize)
+				Pool.push_back(Blocks.back());
+			else
+				::operator delete(Blocks.back());
+			Blocks.pop_back();
+		}
+	}
+}
+
+std::unique_ptr<net::connection> net::connection::materialize(net::entry const& Entry, net::context_pool& Contexts)
+{
+	std::unique_ptr<net::connection> Result = std::make_unique<net::connection>(Contexts.acquire(), Entry);
+	boost::system::error_code Error;
+
+	Result->socket->assign(Entry.family == 6 ? boost::asio::ip::tcp::v6() : boost::asio::ip::tcp::v4(), Entry.descriptor, Error);
+	if (Error)
+	{
+		// Prefetched block belongs to Result already
+		::close(Entry.descriptor);
+		return nullptr;
+	}
+	return Result;
+}
+
+void net::connection::discard(net::entry const& Entry)
+{
+	net::buffer::recycle(Entry.prefetched);
+	::close(Entry.descriptor);
+}
+
+static boost::system::error_code last_error(void)
+{
+	return boost::system::error_code(errno, boost::system::system_category());
+}
+
+/*
+*	Socket may be non-blocking if async operations have been started on it, then we wait here
+*/
+static bool wait_socket(const int Descriptor, const short Events)
+{
+	pollfd Descriptors[1] = { { Descriptor, Events, 0 } };
+
+	return ::poll(Descriptors, 1, -1) > 0;
+}
+
+static constexpr std::size_t WriteVectors = 64;
+
+/*
+*	Gathered write of Parts by sendmsg(), partial writes are continued from the first byte which is not sent
+*/
+static std::size_t send_parts(const int Descriptor, std::span<const std::string_view> Parts, boost::system::error_code& Error)
+{
+	std::size_t Result = 0;
+
+	for (std::size_t First = 0; First < Parts.size(); First += WriteVectors)
+	{
+		std::array<iovec, WriteVectors> Vectors;
+		const std::size_t Count = std::min(WriteVectors, Parts.size() - First);
+		std::size_t Current = 0;
+
+		for (std::size_t Index = 0; Index < Count; Index += 1)
+			Vectors[Index] = { const_cast<char*>(Parts[First + Index].data()), Parts[First + Index].size() };
+
+		while (Current < Count)
+		{
+			// sendmsg() is writev() which does not raise SIGPIPE
+			msghdr Message = { };
+			Message.msg_iov = Vectors.data() + Current;
+			Message.msg_iovlen = Count - Current;
+
+			const ssize_t Written = ::sendmsg(Descriptor, &Message, MSG_NOSIGNAL);
+
+			if (Written < 0)
+			{
+				if (errno == EINTR || ((errno == EAGAIN || errno == EWOULDBLOCK) && wait_socket(Descriptor, POLLOUT)))
+					continue;
+				Error = last_error();
+				return Result;
+			}
+
+			// Partial write: skip vectors which are sent and move into the first one which is not
+			std::size_t Left = static_cast<std::size_t>(Written);
+
+			Result += Left;
+			while (Current < Count && Left >= Vectors[Current].iov_len)
+			{
+				Left -= Vectors[Current].iov_len;
+				Current += 1;
+			}
+			if (Current < Count)
+			{
+				Vectors[Current].iov_base = static_cast<char*>(Vectors[Current].iov_base) + Left;
+				Vectors[Current].iov_len -= Left;
+			}
+		}
+	}
+	return Result;
+}
+
+# ifdef NETORDERING_IO_URING
+/*
+*	io_uring of the thread for I/O of connections which are accepted by backend::io_uring.
+*	Its provided buffers are blocks of net::buffer: the block which kernel has filled is given to read() as is
+*	and a new block from the pool takes its place, so data is not copied out of the ring.
+*	Reads are blocking and one at a time per thread, so a few buffers are enough.
+*/
+struct connection_uring final
+{
+	static constexpr unsigned Entries = 16;
+	static constexpr unsigned Provided = 4;
+	static constexpr std::uint16_t Group = 0;
+
+	std::optional<net::uring> Ring;
+	std::array<net::buffer, Provided> Blocks;
+
+	connection_uring(void)
+	{
+		try
+		{
+			Ring.emplace(Entries);
+		}
+		catch (std::system_error const&)
+		{
+			return;
+		}
+
+		if (!Ring->provide(Group, Provided))
+		{
+			Ring.reset();
+			return;
+		}
+		for (std::uint16_t Id = 0; Id < Provided; Id += 1)
+			Ring->recycle(Blocks[Id].data(), static_cast<unsigned>(Blocks[Id].capacity()), Id);
+	}
+};
+
+static connection_uring* local_connection_uring(void)
+{
+	thread_local connection_uring Local;
+
+	return Local.Ring.has_value() ? &Local : nullptr;
+}
+
+/*
+*	Submits what is prepared and waits for Count completions. If submit() fails, requests are cancelled and
+*	their completions are reaped into Callback, so kernel does not touch the caller's memory after it returns.
+*	false if even that fails: the ring is destroyed and what the requests have done is unknown
+*/
+template<typename Function>
+static bool uring_wait(connection_uring& Local, const std::size_t Count, Function&& Callback)
+{
+	std::size_t Done = 0;
+
+	while (Done < Count)
+	{
+		if (Local.Ring->submit(1) < 0)
+		{
+			if (Local.Ring->cancel(Callback))
+				return true;
+			Local.Ring.reset();
+			return false;
+		}
+		Done += Local.Ring->reap(Callback);
+	}
+	return true;
+}
+
+/*
+*	nullopt if io_uring could not read, then usual recv() is used
+*/
+static std::optional<net::buffer> uring_read(connection_uring& Local, const int Descriptor, boost::system::error_code& Error)
+{
+	while (true)
+	{
+		io_uring_sqe* Receive = Local.Ring->sqe();
+
+		if (Receive == nullptr)
+			return std::nullopt;
+		Receive->opcode = IORING_OP_RECV;
+		Receive->fd = Descriptor;
+		Receive->flags = IOSQE_BUFFER_SELECT;
+		Receive->buf_group = connection_uring::Group;
+
+		int Count = 0;
+		unsigned Flags = 0;
+
+		if (!uring_wait(Local, 1, [&](io_uring_cqe const& Completion) -> void {
+			Count = Completion.res;
+			Flags = Completion.flags;
+		}))
+		{
+			// Data may have been taken from the socket into a buffer which is lost with the ring
+			Error = boost::system::error_code(EIO, boost::system::system_category());
+			return net::buffer();
+		}
+
+		if (Flags & IORING_CQE_F_BUFFER)
+		{
+			const std::uint16_t Id = static_cast<std::uint16_t>(Flags >> IORING_CQE_BUFFER_SHIFT);
+			net::buffer Result = std::move(Local.Blocks[Id]);
+
+			Result.resize(static_cast<std::size_t>(std::max(Count, 0)));
+			Local.Blocks[Id] = net::buffer();
+			Local.Ring->recycle(Local.Blocks[Id].data(), static_cast<unsigned>(Local.Blocks[Id].capacity()), Id);
+
+			if (Count == 0)
+				Error = boost::asio::error::eof;
+			return Result;
+		}
+		if (Count == 0)
+		{
+			Error = boost::asio::error::eof;
+			return net::buffer();
+		}
+		if (Count == -EINTR || ((Count == -EAGAIN || Count == -EWOULDBLOCK) && wait_socket(Descriptor, POLLIN)))
+			continue;
+		// Receive which is cancelled has not taken anything
+		if (Count == -ENOBUFS || Count == -ECANCELED)
+			return std::nullopt;
+
+		Error = boost::system::error_code(-Count, boost::system::system_category());
+		return net::buffer();
+	}
+}
+
+/*
+*	Batches of up to WriteChunks sendmsg() of WriteVectors parts are linked and submitted by one io_uring_enter(),
+*	MSG_WAITALL makes kernel finish every one of them. What is not sent after a short write, a cancelled chain or
+*	a full submission queue goes by send_parts()
+*/
+static std::size_t uring_write(connection_uring& Local, const int Descriptor, std::span<const std::string_view> Parts, boost::system::error_code& Error)
+{
+	static constexpr std::size_t WriteChunks = 4;
+
+	std::array<iovec, WriteChunks * WriteVectors> Vectors;
+	std::array<msghdr, WriteChunks> Messages;
+	std::size_t Result = 0;
+
+	while (!Parts.empty())
+	{
+		std::array<std::size_t, WriteChunks> Sizes = { };
+		std::array<int, WriteChunks> Results = { };
+		const std::size_t Count = std::min(Parts.size(), Vectors.size());
+		const std::size_t Chunks = (Count + WriteVectors - 1) / WriteVectors;
+
+		for (std::size_t Index = 0; Index < Count; Index += 1)
+		{
+			Vectors[Index] = { const_cast<char*>(Parts[Index].data()), Parts[Index].size() };
+			Sizes[Index / WriteVectors] += Parts[Index].size();
+		}
+
+		bool Prepared = true;
+
+		for (std::size_t Chunk = 0; Chunk < Chunks; Chunk += 1)
+		{
+			Messages[Chunk] = { };
+			Messages[Chunk].msg_iov = Vectors.data() + Chunk * WriteVectors;
+			Messages[Chunk].msg_iovlen = std::min(WriteVectors, Count - Chunk * WriteVectors);
+
+			io_uring_sqe* Send = Local.Ring->sqe();
+
+			if (Send == nullptr)
+			{
+				Prepared = false;
+				break;
+			}
+			Send->opcode = IORING_OP_SENDMSG;
+			Send->fd = Descriptor;
+			Send->addr = reinterpret_cast<std::uint64_t>(&Messages[Chunk]);
+			Send->len = 1;
+			Send->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+			Send->flags = Chunk + 1 < Chunks ? IOSQE_IO_LINK : 0;
+			Send->user_data = Chunk;
+		}
+
+		const auto Collect = [&](io_uring_cqe const& Completion) -> void {
+			if (Completion.user_data < WriteChunks)
+				Results[Completion.user_data] = Completion.res;
+		};
+
+		// Chain which does not fit is taken back unsent, chunks which were not prepared stay with 0 bytes
+		if (!(Prepared ? uring_wait(Local, Chunks, Collect) : Local.Ring->cancel(Collect)))
+		{
+			Error = boost::system::error_code(EIO, boost::system::system_category());
+			return Result;
+		}
+
+		std::size_t Sent = 0;
+		bool Short = false;
+
+		for (std::size_t Chunk = 0; Chunk < Chunks && !Short; Chunk += 1)
+		{
+			if (Results[Chunk] < 0)
+			{
+				// The rest of the chain is cancelled, a non-blocking socket or a signal are finished by sendmsg()
+				if (Results[Chunk] != -EAGAIN && Results[Chunk] != -EWOULDBLOCK && Results[Chunk] != -EINTR && Results[Chunk] != -ECANCELED)
+				{
+					Error = boost::system::error_code(-Results[Chunk], boost::system::system_category());
+					return Result + Sent;
+				}
+				Short = true;
+				break;
+			}
+			Sent += static_cast<std::size_t>(Results[Chunk]);
+			Short = static_cast<std::size_t>(Results[Chunk]) < Sizes[Chunk];
+		}
+
+		Result += Sent;
+		if (!Short)
+		{
+			Parts = Parts.subspan(Count);
+			continue;
+		}
+
+		// Parts after Sent bytes, the first of them without its sent prefix
+		std::vector<std::string_view> Rest;
+
+		for (std::string_view const Part : Parts)
+		{
+			if (Sent >= Part.size())
+			{
+				Sent -= Part.size();
+				continue;
+			}
+			Rest.push_back(Part.substr(Sent));
+			Sent = 0;
+		}
+		return Result + send_parts(Descriptor, Rest, Error);
+	}
+	return Result;
+}
+# endif
+
+net::buffer net::connection::read(boost::system::error_code& Error)
+{
+	const int Descriptor = socket->native_handle();
+
+	Error.clear();
+	if (Prefetched != nullptr)
+		return net::buffer(std::exchange(Prefetched, nullptr), PrefetchedSize);
+# ifdef NETORDERING_IO_URING
+	if (connection_uring* Local = Uring ? local_connection_uring() : nullptr; Local != nullptr)
+		if (std::optional<net::buffer> Result = uring_read(*Local, Descriptor, Error); Result.has_value())
+			return std::move(*Result);
+# endif
+
+	net::buffer Result;
+
+	while (true)
+	{
+		const ssize_t Count = ::recv(Descriptor, Result.data(), Result.capacity(), 0);
+
+		if (Count > 0)
+		{
+			Result.resize(static_cast<std::size_t>(Count));
+			return Result;
+		}
+		if (Count == 0)
+		{
+			Error = boost::asio::error::eof;
+			return Result;
+		}
+		if (errno == EINTR || ((errno == EAGAIN || errno == EWOULDBLOCK) && wait_socket(Descriptor, POLLIN)))
+			continue;
+
+		Error = last_error();
+		return Result;
+	}
+}
+
+std::size_t net::connection::read(net::buffer& Into, boost::system::error_code& Error)
+{
+	const int Descriptor = socket->native_handle();
+	const std::size_t Free = Into.capacity() - Into.size();
+
+	Error.clear();
+	if (Free == 0)
+		return 0;
+	if (Prefetched != nullptr)
+	{
+		const std::size_t Count = std::min<std::size_t>(Free, PrefetchedSize);
+
+		Into.append(std::string_view(Prefetched, Count));
+		PrefetchedSize -= static_cast<std::uint32_t>(Count);
+		if (PrefetchedSize == 0)
+			net::buffer::recycle(std::exchange(Prefetched, nullptr));
+		else
+			std::memmove(Prefetched, Prefetched + Count, PrefetchedSize);
+		return Count;
+	}
+
+	while (true)
+	{
+		const ssize_t Count = ::recv(Descriptor, Into.data() + Into.size(), Free, 0);
+
+		if (Count > 0)
+		{
+			Into.resize(Into.size() + static_cast<std::size_t>(Count));
+			return static_cast<std::size_t>(Count);
+		}
+		if (Count == 0)
+		{
+			Error = boost::asio::error::eof;
+			return 0;
+		}
+		if (errno == EINTR || ((errno == EAGAIN || errno == EWOULDBLOCK) && wait_socket(Descriptor, POLLIN)))
+			continue;
+
+		Error = last_error();
+		return 0;
+	}
+}
+
+std::size_t net::connection::send_all(const std::string_view Data, const int Flags, boost::system::error_code& Error)
+{
+	const int Descriptor = socket->native_handle();
+	std::size_t Result = 0;
+
+	Error.clear();
+	while (Result < Data.size())
+	{
+		const ssize_t Written = ::send(Descriptor, Data.data() + Result, Data.size() - Result, Flags | MSG_NOSIGNAL);
+
+		if (Written < 0)
+		{
+			if (errno == EINTR || ((errno == EAGAIN || errno == EWOULDBLOCK) && wait_socket(Descriptor, POLLOUT)))
+				continue;
+			// Out of locked memory for zerocopy pages, the rest is copied
+			if (errno == ENOBUFS && (Flags & MSG_ZEROCOPY))
+				return Result + send_all(Data.substr(Result), 0, Error);
+			Error = last_error();
+			return Result;
+		}
+		if (Flags & MSG_ZEROCOPY)
+			ZeroCopySent += 1;
+		Result += static_cast<std::size_t>(Written);
+	}
+	return Result;
+}
+
+std::size_t net::connection::send_zerocopy(const std::string_view Data, boost::system::error_code& Error)
+{
+	const int Descriptor = socket->native_handle();
+
+	if (Data.size() < ZeroCopyThreshold)
+		return send_all(Data, 0, Error);
+
+	if (!ZeroCopy)
+	{
+		const int Enable = 1;
+
+		if (::setsockopt(Descriptor, SOL_SOCKET, SO_ZEROCOPY, &Enable, sizeof(Enable)) != 0)
+			return send_all(Data, 0, Error);
+		ZeroCopy = true;
+	}
+
+	const std::uint32_t Before = ZeroCopySent;
+	const std::size_t Result = send_all(Data, MSG_ZEROCOPY, Error);
+
+	// Every zerocopy send() has an id, kernel reports ranges of ids which it has released to the error queue
+	std::uint32_t Released = Before;
+	while (Released != ZeroCopySent)
+	{
+		char Control[128];
+		msghdr Message = { };
+		Message.msg_control = Control;
+		Message.msg_controllen = sizeof(Control);
+
+		if (::recvmsg(Descriptor, &Message, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+		{
+			if (errno == EINTR || ((errno == EAGAIN || errno == EWOULDBLOCK) && wait_socket(Descriptor, 0)))
+				continue;
+			break;
+		}
+
+		for (cmsghdr* Header = CMSG_FIRSTHDR(&Message); Header != nullptr; Header = CMSG_NXTHDR(&Message, Header))
+		{
+			sock_extended_err const* Extended = reinterpret_cast<sock_extended_err const*>(CMSG_DATA(Header));
+
+			if (Extended->ee_errno == 0 && Extended->ee_origin == SO_EE_ORIGIN_ZEROCOPY)
+				Released = Extended->ee_data + 1;
+		}
+	}
+	return Result;
+}
+
+std::size_t net::connection::sendfile(net::file const& File, boost::system::error_code& Error)
+{
+	return sendfile(File, 0, File.size(), Error);
+}
+
+std::size_t net::connection::sendfile(net::file const& File, const std::size_t Offset, const std::size_t Count, boost::system::error_code& Error)
+{
+	const int Descriptor = socket->native_handle();
+	off_t Position = static_cast<off_t>(Offset);
+	std::size_t Result = 0;
+
+	Error.clear();
+	while (Result < Count)
+	{
+		const ssize_t Sent = ::sendfile(Descriptor, File.descriptor(), &Position, Count - Result);
+
+		if (Sent < 0)
+		{
+			if (errno == EINTR || ((errno == EAGAIN || errno == EWOULDBLOCK) && wait_socket(Descriptor, POLLOUT)))
+				continue;
+			Error = last_error();
+			return Result;
+		}
+		if (Sent == 0)
+			break;
+		Result += static_cast<std::size_t>(Sent);
+	}
+	return Result;
+}
+
+std::size_t net::connection::write(std::initializer_list<std::string_view> Parts, boost::system::error_code& Error)
+{
+	return write(std::span<const std::string_view>(Parts.begin(), Parts.size()), Error);
+}
+
+std::size_t net::connection::write(std::span<const std::string_view> Parts, boost::system::error_code& Error)
+{
+	const int Descriptor = socket->native_handle();
+
+	Error.clear();
+# ifdef NETORDERING_IO_URING
+	if (connection_uring* Local = Uring ? local_connection_uring() : nullptr; Local != nullptr)
+		return uring_write(*Local, Descriptor, Parts, Error);
+# endif
+	return send_parts(Descriptor, Parts, Error);
+}
+
 std::size_t net::server::get_limit_executor(void) const
 {
-	return LimitExecutor.load(std::memory_order_relaxed);
+	return LimitExecutor.load(std::memory_order_relaxed);
+}
+
+void net::server::launch(void)
+{
+	Updater = std::thread([this](void) -> void {
+		while (Enabled.load(std::memory_order_acquire))
+		{
+			const std::size_t Available = available();
+
+			if (Available == 0)
+			{
+				wait_available();
+				continue;
+			}
+
+			// Connections which are taken from the order and are not submitted yet are seen by drain() through it
+			Holding.store(true, std::memory_order_seq_cst);
+
+			std::size_t Submitted = 0;
+
+			// Clients which are already served go before new ones
+			while (Submitted < Available)
+			{
+				std::unique_ptr<connection> Connection = resume();
+
+				if (Connection == nullptr)
+					break;
+				dispatch(std::move(Connection));
+				Submitted += 1;
+			}
+
+			const bool CachedStealing = Stealing.load(std::memory_order_acquire);
+			std::unique_ptr<connection> Connection = Submitted < Available ? pull_one() : nullptr;
+
+			if (Connection == nullptr && Submitted < Available && CachedStealing)
+				Connection = steal();
+			if (Connection != nullptr)
+			{
+				submit(std::move(Connection));
+				Submitted += 1;
+				for (std::unique_ptr<connection>& Rest : pull_batch(Available - Submitted))
+					submit(std::move(Rest));
+			}
+			Holding.store(false, std::memory_order_seq_cst);
+
+			if (Submitted == 0)
+			{
+				const auto Predicate = [this](void) -> bool { return ready() || !Resumed.empty(); };
+
+				// Peers do not notify us, so idle server looks at them once per StealInterval
+				if (CachedStealing)
+					Ready.wait_until(std::chrono::steady_clock::now() + StealInterval, Predicate);
+				else
+					Ready.wait(Predicate);
+			}
+		}
+	});
+}
+
+void net::server::set_peers(std::vector<std::weak_ptr<net::server>> __Peers)
+{
+	std::lock_guard<std::mutex> PeersLockGuard(PeersMutex);
+
+	Peers = std::move(__Peers);
+	NextPeer = 0;
+}
+
+void net::server::set_stealing(const bool __Stealing)
+{
+	Stealing.store(__Stealing, std::memory_order_release);
+	Ready.notify_all();
+}
+
+std::unique_ptr<net::connection> net::server::steal(void)
+{
+	std::shared_ptr<net::server> Victim = nullptr;
+
+	{
+		std::lock_guard<std::mutex> PeersLockGuard(PeersMutex);
+
+		for (std::size_t Offset = 0; Offset < Peers.size() && Victim == nullptr; Offset += 1)
+		{
+			std::shared_ptr<net::server> Peer = Peers[(NextPeer + Offset) % Peers.size()].lock();
+
+			// The last connection is left to its own shard
+			if (Peer != nullptr && Peer.get() != this && Peer->size() > 1)
+				Victim = std::move(Peer);
+		}
+		NextPeer += 1;
+	}
+
+	if (Victim == nullptr)
+		return nullptr;
+
+	// Connection is built on io_contexts of this server, only its own CoDel and counters see the client
+	if (std::optional<net::entry> Entry = Victim->pull_entry(); Entry.has_value() && !stale(*Entry))
+		return net::connection::materialize(*Entry, *Pool.load(std::memory_order_acquire));
+	return nullptr;
+}
+
+std::size_t net::server::available(void) const
+{
+	if (Executors != nullptr)
+		return Executors->available();
+
+# ifdef BOOST_ASIO_HAS_CO_AWAIT
+	const std::size_t CachedLimit = LimitExecutor.load(std::memory_order_acquire);
+	const std::size_t Active = Coroutines->Active.load(std::memory_order_acquire);
+
+	if (CachedLimit == 0)
+		return std::numeric_limits<std::size_t>::max();
+	return Active < CachedLimit ? CachedLimit - Active : 0;
+# else
+	return 0;
+# endif
+}
+
+void net::server::wait_available(void)
+{
+	if (Executors != nullptr)
+	{
+		Executors->wait_available([this](void) -> bool { return !Enabled.load(std::memory_order_acquire); });
+		return;
+	}
+
+# ifdef BOOST_ASIO_HAS_CO_AWAIT
+	const std::size_t Epoch = Coroutines->Done.epoch();
+
+	Coroutines->Done.wait([&](void) -> bool {
+		return Coroutines->Done.epoch() != Epoch || available() != 0 || !Enabled.load(std::memory_order_acquire);
+	});
+# endif
+}
+
+void net::server::submit(std::unique_ptr<net::connection> Connection)
+{
+	Waits->record(static_cast<std::uint64_t>((std::chrono::steady_clock::now() - Connection->accepted).count()));
+	dispatch(std::move(Connection));
+}
+
+std::unique_ptr<net::connection> net::server::resume(void)
+{
+	while (std::optional<resumed> Next = Resumed.pop())
+	{
+		// Late connection is closed like an idle one, the client has its previous responses already
+		if (late(Next->Since, Resumed.empty()))
+			continue;
+
+		Waits->record(static_cast<std::uint64_t>((std::chrono::steady_clock::now().time_since_epoch() - std::chrono::nanoseconds(Next->Since)).count()));
+		return std::move(Next->Connection);
+	}
+	return nullptr;
+}
+
+void net::server::dispatch(std::unique_ptr<net::connection> Connection)
+{
+	Connection->Parking = Parking;
+
+	if (Executors != nullptr)
+	{
+		Executors->submit(std::move(Connection));
+		return;
+	}
+
+# ifdef BOOST_ASIO_HAS_CO_AWAIT
+	const std::shared_ptr<coroutines> State = Coroutines;
+	const boost::asio::ip::tcp::socket::executor_type Executor = Connection->get_executor();
+
+	State->Active.fetch_add(1, std::memory_order_acq_rel);
+	boost::asio::co_spawn(Executor, State->Handler(std::move(Connection)),
+		[State, Durations = Durations, Start = std::chrono::steady_clock::now()](std::exception_ptr) -> void {
+			Durations->record(static_cast<std::uint64_t>((std::chrono::steady_clock::now() - Start).count()));
+			State->Active.fetch_sub(1, std::memory_order_acq_rel);
+			State->Done.notify_one();
+		});
+# endif
+}
+
+bool net::server::drain(const std::chrono::steady_clock::time_point Deadline)
+{
+	// Listening sockets stay open, clients in the kernel backlog wait there for enable() or the next process
+	disable();
+	Parking->close();
+
+	while (!idle())
+	{
+		const std::chrono::steady_clock::time_point Now = std::chrono::steady_clock::now();
+
+		if (Now >= Deadline)
+		{
+			// Running handlers are not interrupted, only clients which have not reached one are rejected
+			reject_pending();
+			while (Resumed.pop())
+				continue;
+			return false;
+		}
+
+		// Handler which finishes wakes us up, the interval covers clients which are dropped on the way to it
+		const std::chrono::steady_clock::time_point Until = std::min(Deadline, Now + DrainInterval);
+
+		if (Executors != nullptr)
+			Executors->wait_idle(Until);
+# ifdef BOOST_ASIO_HAS_CO_AWAIT
+		else
+			Coroutines->Done.wait_until(Until, [this](void) -> bool { return Coroutines->Active.load(std::memory_order_acquire) == 0; });
+# endif
+	}
+	return true;
+}
+
+bool net::server::idle(void)
+{
+	// Every client is counted at least once: flags are raised before it leaves one place and lowered after it reaches the next
+	{
+		std::lock_guard<std::mutex> ListenersProtectorLockGuard(ListenersProtector);
+
+		for (auto& Listener : Listeners)
+			if (Listener->size() != 0)
+				return false;
+	}
+	if (Transferring.load(std::memory_order_seq_cst) || !empty() || !Resumed.empty() || Holding.load(std::memory_order_seq_cst))
+		return false;
+	if (Executors != nullptr)
+		return Executors->busy() == 0;
+# ifdef BOOST_ASIO_HAS_CO_AWAIT
+	return Coroutines->Active.load(std::memory_order_seq_cst) == 0;
+# else
+	return true;
+# endif
+}
+
+void net::server::interrupt(void)
+{
+	if (Executors != nullptr)
+		Executors->interrupt();
+
+# ifdef BOOST_ASIO_HAS_CO_AWAIT
+	if (Coroutines != nullptr)
+		Coroutines->Done.notify_all();
+# endif
+}
+
+std::vector<std::size_t> net::server::listeners(void)
+{
+	std::vector<std::size_t> Result;
+
+	ListenersProtector.lock();
+	for (decltype(Listeners)::iterator Iterator = Listeners.begin(); Iterator != Listeners.end(); Iterator += 1)
+		Result.push_back(Iterator->get()->get_port());
+	ListenersProtector.unlock();
+
+	return Result;
+}
+
+std::shared_ptr<net::parking> net::server::make_parking(void)
+{
+	// Readable connection waits for an executor in Resumed, so it is admitted like a new client
+	return std::make_shared<net::parking>([this](std::unique_ptr<net::connection> Connection) -> void {
+		resumed Next = { std::move(Connection), std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() };
+
+		Resumed.try_push(Next, 0);
+		Ready.notify_one();
+	});
+}
+
+void net::server::park(std::unique_ptr<net::connection> Connection)
+{
+	Parking->park(std::move(Connection));
+}
+
+std::chrono::nanoseconds net::server::get_idle_timeout(void) const
+{
+	return std::chrono::nanoseconds(Parking->get_timeout());
+}
+
+net::metrics net::server::snapshot(void)
+{
+	net::metrics Result = queue::snapshot();
+
+	Result.queue_wait = Waits->snapshot();
+	Result.handler = Durations->snapshot();
+	Result.executors = LimitExecutor.load(std::memory_order_relaxed);
+	Result.parked = Parking->size();
+	if (Executors != nullptr)
+		Result.busy = Executors->busy();
+# ifdef BOOST_ASIO_HAS_CO_AWAIT
+	else
+		Result.busy = Coroutines->Active.load(std::memory_order_relaxed);
+# endif
+
+	return Result;
+}
+
+std::vector<std::size_t> net::server::active_listeners(void)
+{
+	std::vector<std::size_t> Result;
+
+	ListenersProtector.lock();
+	for (decltype(Listeners)::iterator Iterator = Listeners.begin(); Iterator != Listeners.end(); Iterator += 1)
+		if (Iterator->get()->is_enabled())
+			Result.push_back(Iterator->get()->get_port());
+	ListenersProtector.unlock();
+
+	return Result;
+}
+
+net::queue::share net::queue::get_share(const std::size_t Port)
+{
+	std::lock_guard<std::mutex> ListenersProtectorLockGuard(ListenersProtector);
+	std::unordered_map<std::size_t, share>::const_iterator Iterator = Shares.find(Port);
+
+	return Iterator == Shares.end() ? share() : Iterator->second;
+}
+
+void net::queue::launcher(void)
+{
+	Updater = std::thread([&](void) -> void {
+		struct flow final
+		{
+			std::shared_ptr<net::listener> Listener;
+			std::size_t Weight;
+			std::size_t Deficit;
+		};
+		struct group final
+		{
+			std::size_t Priority;
+			std::size_t Cursor;
+			std::vector<flow> Flows;
+		};
+
+		// Classes are sorted by priority, higher first
+		std::vector<group> Classes;
+		std::size_t SnapshotVersion = ListenersVersion.load(std::memory_order_acquire) - 1;
+
+		while (Enabled.load(std::memory_order_acquire))
+		{
+			const std::size_t Epoch = Arrivals.epoch();
+			bool Moved = false;
+
+			if (SnapshotVersion != ListenersVersion.load(std::memory_order_acquire))
+			{
+				std::lock_guard<std::mutex> ListenersProtectorLockGuard(ListenersProtector);
+
+				SnapshotVersion = ListenersVersion.load(std::memory_order_acquire);
+				Classes.clear();
+				for (auto& Listener : Listeners)
+				{
+					std::unordered_map<std::size_t, share>::const_iterator Share = Shares.find(Listener->get_port());
+					const share Cached = Share == Shares.end() ? share() : Share->second;
+
+					std::vector<group>::iterator Group = Classes.begin();
+					while (Group != Classes.end() && Group->Priority > Cached.Priority)
+						Group += 1;
+					if (Group == Classes.end() || Group->Priority != Cached.Priority)
+						Group = Classes.insert(Group, group{ Cached.Priority, 0, { } });
+
+					Group->Flows.push_back(flow{ Listener, Cached.Weight, 0 });
+				}
+
+				AppliedVersion.store(SnapshotVersion, std::memory_order_release);
+				Applied.notify_all();
+			}
+
+			const std::size_t CachedBatch = AcceptBatch.load(std::memory_order_acquire);
+			const std::size_t CachedLimit = LimitOrder.load(std::memory_order_acquire);
+			std::size_t Published = 0;
+
+			// Clients which are taken from listeners and are not in the order yet are seen by server::drain() through it
+			Transferring.store(true, std::memory_order_seq_cst);
+
+			// In backlog mode only free places of the order are moved, the rest stays in listeners and kernel backlog
+			std::size_t Room = std::numeric_limits<std::size_t>::max();
+			if (CachedLimit != 0 && RejectionKind.load(std::memory_order_acquire) == rejection::backlog)
+			{
+				Room = CachedLimit > size() ? CachedLimit - size() : 0;
+				if (Room == 0)
+				{
+					Backlogged.store(true, std::memory_order_seq_cst);
+					Room = CachedLimit > size() ? CachedLimit - size() : 0;
+				}
+			}
+			std::shared_ptr<const net::rejection_policy> Policy = nullptr;
+
+			for (group& Group : Classes)
+			{
+				const std::size_t Count = Group.Flows.size();
+
+				for (std::size_t Offset = 0; Offset < Count && Room != 0; Offset += 1)
+				{
+					flow& Flow = Group.Flows[(Group.Cursor + Offset) % Count];
+
+					// Idle port does not save credit for later
+					if (Flow.Listener->size() == 0)
+					{
+						Flow.Deficit = 0;
+						continue;
+					}
+
+					Flow.Deficit += Flow.Weight * CachedBatch;
+
+					std::vector<net::entry> Batch = Flow.Listener->pull_entries(std::min(Flow.Deficit, Room));
+
+					if (Batch.empty())
+					{
+						Flow.Deficit = 0;
+						continue;
+					}
+
+					// Fair order appends clients which are pushed out of it, they may be of another port
+					const std::size_t Pulled = Batch.size();
+					const std::size_t Accepted = Fair->enabled() ? Fair->push(Batch, CachedLimit) : Queue.try_push_bulk(Batch, CachedLimit);
+
+					Moved = true;
+					Published += Accepted;
+					Flow.Deficit = Flow.Listener->size() == 0 ? 0 : Flow.Deficit - Pulled;
+					if (Room != std::numeric_limits<std::size_t>::max())
+						Room -= std::min(Room, Pulled);
+
+					if (Accepted < Batch.size() && Policy == nullptr)
+						Policy = Rejection.load(std::memory_order_acquire);
+					for (std::size_t Index = Accepted; Index < Batch.size(); Index += 1)
+					{
+						const net::reason Reason = Rejector->reject(Batch[Index], Policy) ? net::reason::order : net::reason::overflow;
+						net::listener* Owner = Flow.Listener.get();
+
+						if (Batch[Index].port != Owner->get_port())
+							for (group& Other : Classes)
+								for (flow& Peer : Other.Flows)
+									if (Peer.Listener->get_port() == Batch[Index].port)
+										Owner = Peer.Listener.get();
+						Owner->Counters.reject(Reason, 1);
+					}
+				}
+				Group.Cursor = Count == 0 ? 0 : (Group.Cursor + 1) % Count;
+
+				if (Moved)
+					break;
+			}
+
+			Transferring.store(false, std::memory_order_seq_cst);
+			if (Published != 0)
+				Ready.notify_all();
+
+			if (!Moved)
+				Arrivals.wait([&](void) -> bool {
+					return Arrivals.epoch() != Epoch || !Enabled.load(std::memory_order_acquire);
+				});
+		}
+	});
+}
+
+void net::queue::update(void)
+{
+	if (Listeners.size() == 0)
+		Status.store(false, std::memory_order_release);
+
+	std::lock_guard<std::mutex> ListenersProtectorLockGuard(ListenersProtector);
+
+	bool Result = false;
+	for (auto& Listener : Listeners)
+		Result |= Listener->is_enabled();
+
+	Status.store(Result, std::memory_order_release);
+}
+
+bool net::queue::is_enabled(void) const
+{
+	return Status.load(std::memory_order_relaxed);
+}
+
+[[ nodiscard ]]
+std::unique_ptr<net::connection> net::queue::pull_one(void)
+{
+	net::fair_queue::ticket Ticket;
+
+	while (std::optional<net::entry> Entry = pop(Ticket))
+	{
+		release();
+		if (!stale(*Entry))
+			if (std::unique_ptr<net::connection> Result = net::connection::materialize(*Entry, *Pool.load(std::memory_order_acquire)); Result != nullptr)
+			{
+				Result->Fair = Fair;
+				Result->Ticket = Ticket;
+				return Result;
+			}
+		Fair->release(Ticket);
+	}
+	return nullptr;
+}
+
+[[ nodiscard ]]
+std::unique_ptr<net::connection> net::queue::pull_one_wait(void)
+{
+	while (true)
+	{
+		std::unique_ptr<net::connection> Result = pull_one();
+
+		if (Result != nullptr || !Enabled.load(std::memory_order_acquire))
+			return Result;
+		Ready.wait([this](void) -> bool { return ready(); });
+	}
+}
+
+[[ nodiscard ]]
+std::vector<std::unique_ptr<net::connection>> net::queue::pull_batch(const std::size_t Count)
+{
+	std::vector<std::unique_ptr<net::connection>> Result;
+
+	Result.reserve(std::min(Count, size()));
+	while (Result.size() < Count)
+	{
+		net::fair_queue::ticket Ticket;
+		std::optional<net::entry> Entry = pop(Ticket);
+
+		if (!Entry.has_value())
+			break;
+		if (!stale(*Entry))
+			if (std::unique_ptr<net::connection> Connection = net::connection::materialize(*Entry, *Pool.load(std::memory_order_acquire)); Connection != nullptr)
+			{
+				Connection->Fair = Fair;
+				Connection->Ticket = Ticket;
+				Result.push_back(std::move(Connection));
+				continue;
+			}
+		Fair->release(Ticket);
+	}
+	release();
+	return Result;
+}
+
+bool net::queue::ready(void)
+{
+	return !empty() || !Enabled.load(std::memory_order_acquire);
+}
+
+std::size_t net::queue::reject_pending(void)
+{
+	std::lock_guard<std::mutex> ListenersProtectorLockGuard(ListenersProtector);
+	std::shared_ptr<const net::rejection_policy> Policy = Rejection.load(std::memory_order_acquire);
+	std::size_t Result = 0;
+
+	for (auto& Listener : Listeners)
+		for (net::entry const& Entry : Listener->pull_entries(std::numeric_limits<std::size_t>::max()))
+		{
+			Listener->Counters.reject(Rejector->reject(Entry, Policy) ? net::reason::order : net::reason::overflow, 1);
+			Result += 1;
+		}
+
+	net::fair_queue::ticket Ticket;
+
+	while (std::optional<net::entry> Entry = pop(Ticket))
+	{
+		const net::reason Reason = Rejector->reject(*Entry, Policy) ? net::reason::order : net::reason::overflow;
+
+		for (auto& Listener : Listeners)
+			if (Listener->get_port() == Entry->port)
+			{
+				Listener->Counters.reject(Reason, 1);
+				break;
+			}
+		Result += 1;
+	}
+	release();
+	return Result;
+}
+
+void net::queue::enable(void)
+{
+	std::lock_guard<std::mutex> ThreadSafetyLockGuard(ThreadSafety);
+	ListenersProtector.lock();
+
+	for (auto& Listener : Listeners)
+		Listener->enable();
+
+	ListenersProtector.unlock();
+	update();
+}
+
+void net::queue::disable(void)
+{
+	std::lock_guard<std::mutex> ThreadSafetyLockGuard(ThreadSafety);
+	ListenersProtector.lock();
+
+	for (auto& Listener : Listeners)
+		Listener->disable();
+
+	ListenersProtector.unlock();
+	update();
+}
+
+std::size_t net::queue::size(void)
+{
+	return Queue.size() + Fair->size();
+}
+
+std::size_t net::queue::get_limit_order(void)
+{
+	return LimitOrder.load(std::memory_order_relaxed);
+}
+
+std::size_t net::queue::get_rate(void) const
+{
+	return Bucket.get_rate();
+}
+
+std::size_t net::queue::get_burst(void) const
+{
+	return Bucket.get_burst();
+}
+
+std::size_t net::queue::get_fairness(void) const
+{
+	return Fair->buckets();
+}
+
+std::size_t net::queue::get_accept_batch(void)
+{
+	return AcceptBatch.load(std::memory_order_relaxed);
+}
+
+std::size_t net::queue::get_acceptors(void)
+{
+	return AcceptorsCount.load(std::memory_order_relaxed);
+}
+
+void net::queue::set_rejection(const net::rejection Kind)
+{
+	repolicy([Kind](net::rejection_policy& Next) -> void {
+		Next.kind = Kind;
+	});
+}
+
+void net::queue::set_rejection(net::rejection_policy Policy)
+{
+	repolicy([&Policy](net::rejection_policy& Next) -> void {
+		Next = std::move(Policy);
+	});
+}
+
+net::rejection net::queue::get_rejection(void) const
+{
+	return RejectionKind.load(std::memory_order_relaxed);
+}
+
+void net::queue::set_backend(const net::backend Kind)
+{
+	Backend.store(available(Kind), std::memory_order_release);
+
+	std::lock_guard<std::mutex> ListenersProtectorLockGuard(ListenersProtector);
+	for (auto& Listener : Listeners)
+		Listener->set_backend(Kind);
+}
+
+net::backend net::queue::get_backend(void) const
+{
+	return Backend.load(std::memory_order_relaxed);
+}
+
+void net::queue::provide(net::resources Resources)
+{
+	std::lock_guard<std::mutex> ThreadSafetyLockGuard(ThreadSafety);
+
+	if (Resources.contexts != nullptr)
+	{
+		Contexts = std::move(Resources.contexts);
+		Pool.store(Contexts.get(), std::memory_order_release);
+	}
+	if (Resources.rejections != nullptr)
+		Rejector = std::move(Resources.rejections);
+}
+
+void net::queue::set_contexts(std::shared_ptr<net::context_pool> __Contexts)
+{
+	std::lock_guard<std::mutex> LockGuard(ThreadSafety);
+
+	Retired.push_back(Contexts);
+	Contexts = std::move(__Contexts);
+	Pool.store(Contexts.get(), std::memory_order_release);
+}
+
+std::shared_ptr<net::context_pool> net::queue::get_contexts(void)
+{
+	std::lock_guard<std::mutex> LockGuard(ThreadSafety);
+
+	return Contexts;
+}
+
+std::chrono::nanoseconds net::queue::get_target(void) const
+{
+	return std::chrono::nanoseconds(Codel.get_target());
+}
+
+std::chrono::nanoseconds net::queue::get_max_age(void) const
+{
+	return std::chrono::nanoseconds(MaxAge.load(std::memory_order_relaxed));
+}
+
+bool net::queue::late(const std::int64_t Since, const bool Empty)
+{
+	const std::int64_t CachedMaxAge = MaxAge.load(std::memory_order_relaxed);
+
+	if (CachedMaxAge == 0 && Codel.get_target() == 0)
+		return false;
+
+	const std::int64_t Now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	const std::int64_t Sojourn = Now - Since;
+
+	if (CachedMaxAge != 0 && Sojourn >= CachedMaxAge)
+		Expired.fetch_add(1, std::memory_order_relaxed);
+	else if (Codel.drop(Sojourn, Now, Empty))
+		Dropped.fetch_add(1, std::memory_order_relaxed);
+	else
+		return false;
+	return true;
+}
+
+bool net::queue::stale(net::entry const& Entry)
+{
+	if (!late(Entry.accepted, empty()))
+		return false;
+
+	Rejector->reject(Entry, Rejection.load(std::memory_order_acquire));
+
+	return true;
+}
+
+net::metrics net::queue::snapshot(void)
+{
+	net::metrics Result;
+
+	{
+		std::lock_guard<std::mutex> ListenersProtectorLockGuard(ListenersProtector);
+
+		Result.ports.reserve(Listeners.size());
+		for (auto& Listener : Listeners)
+			Result.ports.push_back(Listener->snapshot());
+	}
+	Result.depth = size();
+	Result.limit = LimitOrder.load(std::memory_order_relaxed);
+	Result.expired = Expired.load(std::memory_order_relaxed);
+	Result.dropped = Dropped.load(std::memory_order_relaxed);
+
+	return Result;
+}
+
+void net::queue::adopt(net::listener& Listener)
+{
+	const bool Backlog = RejectionKind.load(std::memory_order_acquire) == rejection::backlog;
+	const std::size_t CachedBatch = AcceptBatch.load(std::memory_order_acquire);
+	const net::backend CachedBackend = Backend.load(std::memory_order_acquire);
+
+	std::shared_ptr<const net::rejection_policy> Policy = Rejection.load(std::memory_order_acquire);
+
+	// Listeners of the queue are unlimited, in backlog mode they hold only one batch.
+	// They reject only clients over the rate, by the policy of the queue
+	Listener.reconfigure([&](net::listener_config& Next) -> void {
+		Next.rejection = *Policy;
+		Next.rejection.kind = Backlog ? rejection::backlog : Policy->kind;
+		Next.limit = Backlog ? CachedBatch : 0;
+		Next.kind = CachedBackend;
+	});
+	Listener.share(&Bucket);
+	Listener.route(Rejector.get());
+	Listener.release();
+}
+
+std::optional<net::entry> net::queue::pull_entry(void)
+{
+	net::fair_queue::ticket Ticket;
+	std::optional<net::entry> Result = pop(Ticket);
+
+	if (Result.has_value())
+	{
+		Fair->release(Ticket);
+		release();
+	}
+	return Result;
+}
+
+std::optional<net::entry> net::queue::pop(net::fair_queue::ticket& Ticket)
+{
+	if (Fair->size() != 0)
+		if (std::optional<net::entry> Result = Fair->pop(Ticket))
+			return Result;
+	return Queue.pop();
+}
+
+bool net::queue::empty(void) const
+{
+	return Queue.empty() && Fair->size() == 0;
+}
+
+void net::queue::release(void)
+{
+	if (Backlogged.load(std::memory_order_relaxed) && Backlogged.exchange(false, std::memory_order_acq_rel))
+		Arrivals.notify_all();
+}
+
+void net::listener::whileIsNotConstructed(void)
+{
+	Started.wait([this](void) -> bool { return IsConstructed.load(std::memory_order_acquire); });
+
+	std::exception_ptr CachedFailure;
+
+	{
+		std::lock_guard<std::mutex> AcceptorsLockGuard(AcceptorsMutex);
+		CachedFailure = Failure;
+	}
+	if (CachedFailure != nullptr)
+	{
+		// Destructor is not called for an object which has not been constructed
+		stop();
+		for (auto& Acceptor : Acceptors)
+			if (Acceptor->Wake != -1)
+				::close(Acceptor->Wake);
+		for (const int Descriptor : Inherited)
+			if (Descriptor != -1)
+				::close(Descriptor);
+		std::rethrow_exception(CachedFailure);
+	}
+}
+
+void net::listener::bind(boost::asio::ip::tcp::acceptor& Acceptor, const std::size_t __Port)
+{
+	boost::asio::ip::tcp::endpoint EndPoint(boost::asio::ip::tcp::v4(), static_cast<unsigned short>(__Port));
+
+	Acceptor.open(EndPoint.protocol());
+	Acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+# ifdef SO_REUSEPORT
+	Acceptor.set_option(net::reuse_port(true));
+# endif
+	Acceptor.bind(EndPoint);
+	Acceptor.listen();
+	Acceptor.native_non_blocking(true);
+}
+
+void net::listener::rebind(const std::size_t __Port)
+{
+	std::lock_guard<std::mutex> LockGuard(ThreadSafety);
+
+	if (Config.load(std::memory_order_acquire)->port != __Port)
+		bind_all(__Port);
+	reconfigure([__Port](net::listener_config& Next) -> void {
+		Next.port = __Port;
+	});
+}
+
+void net::listener::bind_all(const std::size_t __Port)
+{
+	boost::asio::io_service IO_Service;
+	std::vector<int> Sockets;
+	std::lock_guard<std::mutex> AcceptorsLockGuard(AcceptorsMutex);
+
+	try
+	{
+		for (auto& Acceptor : Acceptors)
+		{
+			if (Acceptor->Retired)
+			{
+				Sockets.push_back(-1);
+				continue;
+			}
+
+			boost::asio::ip::tcp::acceptor Next(IO_Service);
+
+			bind(Next, __Port);
+			Sockets.push_back(Next.release());
+		}
+	}
+	catch (...)
+	{
+		for (const int Descriptor : Sockets)
+			if (Descriptor != -1)
+				::close(Descriptor);
+		throw;
+	}
+
+	for (std::size_t Index = 0; Index < Acceptors.size(); Index += 1)
+	{
+		// Socket of a port which has not been taken yet is replaced
+		if (Acceptors[Index]->Bound != -1)
+			::close(Acceptors[Index]->Bound);
+		Acceptors[Index]->Bound = Sockets[Index];
+		Acceptors[Index]->BoundPort = __Port;
+	}
+}
+
+net::listener::~listener(void)
+{
+	stop();
+
+	for (auto& Acceptor : Acceptors)
+	{
+		if (Acceptor->Wake != -1)
+			::close(Acceptor->Wake);
+		if (Acceptor->Bound != -1)
+			::close(Acceptor->Bound);
+	}
+
+	while (std::optional<net::entry> Entry = Clients.pop())
+		net::connection::discard(*Entry);
+	for (const int Descriptor : Inherited)
+		if (Descriptor != -1)
+			::close(Descriptor);
+}
+
+void net::listener::stop(void)
+{
+	{
+		std::lock_guard<std::mutex> SleepLockGuard(SleepMutex);
+		Enabled.store(false, std::memory_order_seq_cst);
+	}
+	SleepCondition.notify_all();
+	Arrived.notify_all();
+	wake();
+
+	for (auto& Acceptor : Acceptors)
+		if (Acceptor->Thread.joinable())
+			Acceptor->Thread.join();
+}
+
+void net::listener::resize(std::size_t Count)
+{
+# ifndef SO_REUSEPORT
+	Count = 1;
+# endif
+	if (Count == 0)
+		Count = 1;
+
+	std::lock_guard<std::mutex> AcceptorsLockGuard(AcceptorsMutex);
+
+	AcceptorsCount.store(Count, std::memory_order_seq_cst);
+	while (Acceptors.size() < Count)
+	{
+		Acceptors.push_back(std::make_unique<acceptor>());
+		Acceptors.back()->Wake = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+		if (Acceptors.back()->Wake == -1)
+			throw std::system_error(errno, std::generic_category(), "eventfd");
+	}
+
+	for (std::size_t Index = 0; Index < Acceptors.size(); Index += 1)
+		if (Index < Count && Acceptors[Index]->Retired)
+		{
+			if (Acceptors[Index]->Thread.joinable())
+				Acceptors[Index]->Thread.join();
+
+			Acceptors[Index]->Retired = false;
+			launch(Index);
+		}
+		else if (Index >= Count)
+			::eventfd_write(Acceptors[Index]->Wake, 1);
+}
+
+void net::listener::wake(void)
+{
+	std::lock_guard<std::mutex> AcceptorsLockGuard(AcceptorsMutex);
+
+	for (auto& Acceptor : Acceptors)
+		::eventfd_write(Acceptor->Wake, 1);
+}
+
+void net::listener::admit(std::vector<net::entry>& Batch)
+{
+	net::token_bucket* CachedShared = Shared.load(std::memory_order_acquire);
+
+	if (!Bucket.limited() && (CachedShared == nullptr || !CachedShared->limited()))
+		return;
+
+	const std::int64_t Now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	std::size_t Admitted = Bucket.take(Batch.size(), Now);
+
+	if (CachedShared != nullptr)
+	{
+		const std::size_t Granted = CachedShared->take(Admitted, Now);
+
+		// Tokens of the port are given back for clients which the queue has not let through
+		Bucket.refund(Admitted - Granted);
+		Admitted = Granted;
+	}
+	if (Admitted == Batch.size())
+		return;
+
+	std::shared_ptr<const net::rejection_policy> Policy = policy();
+
+	net::rejector* CachedRouted = Routed.load(std::memory_order_acquire);
+	net::rejector& Target = CachedRouted != nullptr ? *CachedRouted : *Rejector;
+
+	for (std::size_t Index = Admitted; Index < Batch.size(); Index += 1)
+		Counters.reject(Target.reject(Batch[Index], Policy) ? net::reason::rate : net::reason::overflow, 1);
+	Batch.resize(Admitted);
+}
+
+void net::listener::publish(std::vector<net::entry>& Batch)
+{
+	admit(Batch);
+	if (Batch.empty())
+		return;
+
+	std::shared_ptr<const net::listener_config> Cached = Config.load(std::memory_order_acquire);
+	const std::size_t Accepted = Clients.try_push_bulk(Batch, Cached->limit);
+
+	if (Accepted != 0)
+	{
+		Arrived.notify_all();
+		if (notifier* CachedObserver = Observer.load(std::memory_order_acquire); CachedObserver != nullptr)
+			CachedObserver->notify_one();
+	}
+
+	Counters.accepted.fetch_add(Batch.size(), std::memory_order_relaxed);
+	if (Accepted < Batch.size())
+	{
+		// Policy shares ownership of the snapshot, it is not copied for the rejector
+		std::shared_ptr<const net::rejection_policy> Policy(Cached, &Cached->rejection);
+		net::rejector* CachedRouted = Routed.load(std::memory_order_acquire);
+		net::rejector& Target = CachedRouted != nullptr ? *CachedRouted : *Rejector;
+
+		for (std::size_t Index = Accepted; Index < Batch.size(); Index += 1)
+			Counters.reject(Target.reject(Batch[Index], Policy) ? net::reason::limit : net::reason::overflow, 1);
+	}
+	Batch.clear();
+}
+
+/*
+*	Clients of one acceptor thread which are accepted in prefetch mode but have sent nothing yet.
+*	They are in the epoll set of the thread until they are readable or their deadline is passed
+*/
+class first_bytes final
+{
+	/*
+	*	Ordered by time, prefetch timeout of the port may be lowered while clients of the old one are waiting
+	*/
+	using deadlines = std::multimap<std::int64_t, int>;
+
+	struct waiting final
+	{
+		net::entry Entry;
+		deadlines::iterator Deadline;
+	};
+
+	int Poller;
+	std::unordered_map<int, waiting> Waiting;
+	deadlines Deadlines;
+
+	public:
+		explicit first_bytes(const int __Poller) : Poller(__Poller)
+		{ }
+
+		explicit first_bytes(first_bytes const&) = delete;
+		explicit first_bytes(first_bytes const&&) = delete;
+
+		~first_bytes(void)
+		{
+			for (auto& [Descriptor, Client] : Waiting)
+				net::connection::discard(Client.Entry);
+		}
+
+		/*
+		*	Reads first bytes of Entry, true if it is ready for the order. Otherwise Entry is kept here for Timeout
+		*	or closed if it is closed by the peer
+		*/
+		bool take(net::entry& Entry, const std::int64_t Timeout)
+		{
+			net::buffer Block;
+			const ssize_t Count = ::recv(Entry.descriptor, Block.data(), Block.capacity(), MSG_DONTWAIT);
+
+			if (Count > 0)
+			{
+				// Time in the order starts when the client has something to serve
+				Entry.accepted = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+				Entry.prefetched_size = static_cast<std::uint32_t>(Count);
+				Entry.prefetched = Block.detach();
+				return true;
+			}
+
+			epoll_event Event = { };
+			Event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+			Event.data.fd = Entry.descriptor;
+
+			if (Count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) && Timeout > 0
+				&& ::epoll_ctl(Poller, EPOLL_CTL_ADD, Entry.descriptor, &Event) == 0)
+			{
+				Waiting[Entry.descriptor] = waiting{ Entry, Deadlines.emplace(Entry.accepted + Timeout, Entry.descriptor) };
+				return false;
+			}
+
+			net::connection::discard(Entry);
+			return false;
+		}
+
+		/*
+		*	Descriptor is readable, false if it is not a waiting client
+		*/
+		bool ready(const int Descriptor, std::vector<net::entry>& Batch)
+		{
+			std::unordered_map<int, waiting>::iterator Iterator = Waiting.find(Descriptor);
+
+			if (Iterator == Waiting.end())
+				return false;
+
+			net::entry Entry = Iterator->second.Entry;
+
+			::epoll_ctl(Poller, EPOLL_CTL_DEL, Descriptor, nullptr);
+			Deadlines.erase(Iterator->second.Deadline);
+			Waiting.erase(Iterator);
+			if (take(Entry, 0))
+				Batch.push_back(Entry);
+			return true;
+		}
+
+		/*
+		*	Closes clients which are silent too long, returns milliseconds until the next deadline or -1
+		*/
+		int expire(void)
+		{
+			const std::int64_t Now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+			while (!Deadlines.empty())
+			{
+				auto [Deadline, Descriptor] = *Deadlines.begin();
+
+				if (Deadline > Now)
+					return static_cast<int>(std::min<std::int64_t>((Deadline - Now) / 1000000 + 1, std::numeric_limits<int>::max()));
+
+				std::unordered_map<int, waiting>::iterator Iterator = Waiting.find(Descriptor);
+
+				::epoll_ctl(Poller, EPOLL_CTL_DEL, Descriptor, nullptr);
+				net::connection::discard(Iterator->second.Entry);
+				Waiting.erase(Iterator);
+				Deadlines.erase(Deadlines.begin());
+			}
+			return -1;
+		}
+};
+
+std::chrono::nanoseconds net::listener::get_prefetch(void) const
+{
+	return Config.load(std::memory_order_relaxed)->prefetch;
 }
 
-std::vector<std::size_t> net::server::listeners(void)
+void net::listener::launch(const std::size_t Index)
 {
-	std::vector<std::size_t> Result;
+	// Inherited socket is given to one acceptor thread only once, restarted thread binds its own
+	const int Descriptor = Index < Inherited.size() ? std::exchange(Inherited[Index], -1) : -1;
 
-	ListenersProtector.lock();
-	for (decltype(Listeners)::iterator Iterator = Listeners.begin(); Iterator != Listeners.end(); Iterator += 1)
-		Result.push_back(Iterator->get()->get_port());
-	ListenersProtector.unlock();
+	Acceptors[Index]->Thread = std::thread([this, Index, Descriptor, Wake = Acceptors[Index]->Wake](void) -> void {
+		boost::asio::io_service IO_ServiceAcceptor;
+		boost::asio::ip::tcp::acceptor Acceptor(IO_ServiceAcceptor);
+		std::size_t CachedPort = Config.load(std::memory_order_acquire)->port;
+		std::size_t Refused = 0;
+		std::vector<net::entry> Batch;
+		const int Poller = ::epoll_create1(EPOLL_CLOEXEC);
+		first_bytes Silent(Poller);
+		bool Watched = false;
+		int Deferred = 0;
+# ifdef NETORDERING_IO_URING
+		// Ring of accept_uring() lives as long as the thread, it is not created again on every wake-up
+		std::optional<net::uring> Ring;
+# endif
 
-	return Result;
-}
+		try
+		{
+			if (Poller == -1)
+				throw std::system_error(errno, std::system_category(), "Can not create epoll instance");
 
-std::vector<std::size_t> net::server::active_listeners(void)
-{
-	std::vector<std::size_t> Result;
+			if (Descriptor != -1)
+			{
+				sockaddr_storage Address = { };
+				socklen_t AddressSize = sizeof(Address);
 
-	ListenersProtector.lock();
-	for (decltype(Listeners)::iterator Iterator = Listeners.begin(); Iterator != Listeners.end(); Iterator += 1)
-		if (Iterator->get()->is_enabled())
-			Result.push_back(Iterator->get()->get_port());
-	ListenersProtector.unlock();
+				::getsockname(Descriptor, reinterpret_cast<sockaddr*>(&Address), &AddressSize);
+				Acceptor.assign(Address.ss_family == AF_INET6 ? boost::asio::ip::tcp::v6() : boost::asio::ip::tcp::v4(), Descriptor);
+				Acceptor.native_non_blocking(true);
 
-	return Result;
-}
+				// Previous process may have left TCP_DEFER_ACCEPT on it
+				Deferred = -1;
+			}
+			else
+			{
+				int Bound = -1;
+
+				// Thread which has been launched while set_port() was binding loads the new port already
+				{
+					std::lock_guard<std::mutex> AcceptorsLockGuard(AcceptorsMutex);
+
+					if (Acceptors[Index]->BoundPort == CachedPort)
+						Bound = std::exchange(Acceptors[Index]->Bound, -1);
+				}
+
+				if (Bound != -1)
+					Acceptor.assign(boost::asio::ip::tcp::v4(), Bound);
+				else
+					bind(Acceptor, CachedPort);
+			}
+		}
+		catch (...)
+		{
+			{
+				std::lock_guard<std::mutex> AcceptorsLockGuard(AcceptorsMutex);
+
+				// Retired acceptor is launched again by the next set_acceptors()
+				Acceptors[Index]->Retired = true;
+				if (Failure == nullptr)
+					Failure = std::current_exception();
+			}
+			if (Descriptor != -1 && !Acceptor.is_open())
+				::close(Descriptor);
+			if (Poller != -1)
+				::close(Poller);
+			IsConstructed.store(true, std::memory_order_seq_cst);
+			Started.notify_all();
+			return;
+		}
+
+		epoll_event WakeEvent = { };
+		WakeEvent.events = EPOLLIN;
+		WakeEvent.data.fd = Wake;
+		::epoll_ctl(Poller, EPOLL_CTL_ADD, Wake, &WakeEvent);
+
+		{
+			std::lock_guard<std::mutex> AcceptorsLockGuard(AcceptorsMutex);
+			Acceptors[Index]->Listening = Acceptor.native_handle();
+		}
+		IsConstructed.store(true, std::memory_order_seq_cst);
+		Started.notify_all();
 
-void net::queue::launcher(void)
-{
-	Updater = std::thread([&](void) -> void {
 		while (Enabled.load(std::memory_order_acquire))
 		{
-			std::lock_guard<std::mutex> ListenersProtectorLockGuard(ListenersProtector);
+			{
+				std::unique_lock<std::mutex> SleepLock(SleepMutex);
+				SleepCondition.wait(SleepLock, [this](void) -> bool {
+					return !Sleep.load(std::memory_order_acquire) || !Enabled.load(std::memory_order_acquire);
+				});
+			}
+			if (!Enabled.load(std::memory_order_acquire))
+				break;
+
+			{
+				std::lock_guard<std::mutex> AcceptorsLockGuard(AcceptorsMutex);
+
+				if (Index >= AcceptorsCount.load(std::memory_order_acquire))
+				{
+					Acceptors[Index]->Retired = true;
+					Acceptors[Index]->Listening = -1;
+					if (Acceptors[Index]->Bound != -1)
+						::close(std::exchange(Acceptors[Index]->Bound, -1));
+					::close(Poller);
+					return;
+				}
+			}
+
+			// One snapshot for the whole pass, setters publish a new one and wake us up
+			const std::shared_ptr<const net::listener_config> Cached = Config.load(std::memory_order_acquire);
+			const std::int64_t CachedPrefetch = Cached->prefetch.count();
 
-			for (auto& Listener : Listeners)
+			if (CachedPort != Cached->port && Refused != Cached->port)
 			{
-				std::unique_ptr<net::connection> Connection = Listener->pull_one();
+				boost::asio::ip::tcp::acceptor Next(IO_ServiceAcceptor);
+				int Bound = -1;
 
-				if (Connection != nullptr)
 				{
-					std::lock_guard<std::mutex> QueueProtectorLockGuard(QueueProtector);
-					const std::size_t CachedLimit = LimitOrder.load(std::memory_order_acquire);
+					std::lock_guard<std::mutex> AcceptorsLockGuard(AcceptorsMutex);
 
-					if (CachedLimit == 0 || Queue.size() < CachedLimit)
-						Queue.push(std::move(Connection));
+					if (Acceptors[Index]->BoundPort == Cached->port)
+						Bound = std::exchange(Acceptors[Index]->Bound, -1);
+				}
+
+				// The new socket listens before the old one is closed. set_port() has bound it already, thread
+				// which has been started after that binds its own, port which can not be bound is not retried
+				try
+				{
+					if (Bound != -1)
+						Next.assign(boost::asio::ip::tcp::v4(), Bound);
 					else
+						bind(Next, Cached->port);
+				}
+				catch (boost::system::system_error const&)
+				{
+					if (Bound != -1 && !Next.is_open())
+						::close(Bound);
+					Refused = Cached->port;
+				}
+
+				if (Refused != Cached->port)
+				{
+					// Clients which are in the backlog of the old socket already are not dropped with it
+					while (true)
 					{
-						boost::asio::write(*Connection->socket, boost::asio::buffer(ErrorMessage.data(), ErrorMessage.size()));
+						sockaddr_storage Peer;
+						socklen_t PeerSize = sizeof(Peer);
+						const int Client = ::accept4(Acceptor.native_handle(), reinterpret_cast<sockaddr*>(&Peer), &PeerSize, SOCK_CLOEXEC);
 
-						Connection->socket->close();
+						if (Client == -1)
+						{
+							if (errno == EINTR || errno == ECONNABORTED)
+								continue;
+							break;
+						}
+
+						net::entry Entry = make_entry(Client, CachedPort, Peer);
+
+						if (CachedPrefetch == 0 || Silent.take(Entry, CachedPrefetch))
+							Batch.push_back(Entry);
+					}
+
+					if (Watched)
+						::epoll_ctl(Poller, EPOLL_CTL_DEL, Acceptor.native_handle(), nullptr);
+					Watched = false;
+					Deferred = 0;
+					{
+						std::lock_guard<std::mutex> AcceptorsLockGuard(AcceptorsMutex);
+						Acceptors[Index]->Listening = Next.native_handle();
 					}
+					Acceptor = std::move(Next);
+					CachedPort = Cached->port;
+					Refused = 0;
+
+					if (!Batch.empty())
+						publish(Batch);
+				}
+			}
+
+			// Kernel does not complete accept until data arrives, for a whole number of seconds
+			const int Defer = static_cast<int>((CachedPrefetch + 999999999) / 1000000000);
+
+			if (Defer != Deferred)
+			{
+				::setsockopt(Acceptor.native_handle(), IPPROTO_TCP, TCP_DEFER_ACCEPT, &Defer, sizeof(Defer));
+				Deferred = Defer;
+			}
+
+			std::size_t CachedBatch = Cached->accept_batch;
+			const std::size_t CachedLimit = Cached->limit;
+			const bool Backlog = CachedLimit != 0 && Cached->rejection.kind == rejection::backlog;
+			bool Full = false;
+
+			// In backlog mode full order is not touched, the listening socket is not polled until pull_one() wakes us
+			if (Backlog)
+			{
+				if (Clients.size() >= CachedLimit)
+				{
+					Backlogged.store(true, std::memory_order_seq_cst);
+					Full = Clients.size() >= CachedLimit;
+				}
+				if (!Full)
+					CachedBatch = std::min(CachedBatch, CachedLimit - std::min(CachedLimit, Clients.size()));
+			}
+
+# ifdef NETORDERING_IO_URING
+			// Multishot accept can not stop at the room of the order and does not watch silent clients, so these modes stay on epoll
+			if (!Backlog && CachedPrefetch == 0 && Cached->kind == backend::io_uring)
+			{
+				if (Watched)
+					::epoll_ctl(Poller, EPOLL_CTL_DEL, Acceptor.native_handle(), nullptr);
+				Watched = false;
+
+				if (!accept_uring(Ring, Acceptor, Wake, CachedPort))
+					reconfigure([](net::listener_config& Next) -> void {
+						Next.kind = backend::epoll;
+					});
+				continue;
+			}
+# endif
+
+			if (Watched == Full)
+			{
+				epoll_event Event = { };
+				Event.events = EPOLLIN;
+				Event.data.fd = Acceptor.native_handle();
+
+				::epoll_ctl(Poller, Full ? EPOLL_CTL_DEL : EPOLL_CTL_ADD, Acceptor.native_handle(), &Event);
+				Watched = !Full;
+			}
+
+			std::array<epoll_event, 64> Events;
+			const int Ready = ::epoll_wait(Poller, Events.data(), static_cast<int>(Events.size()), Silent.expire());
+			bool Woken = false;
+			bool Acceptable = false;
+
+			for (int Event = 0; Event < Ready; Event += 1)
+			{
+				if (Events[Event].data.fd == Wake)
+					Woken = true;
+				else if (Events[Event].data.fd == Acceptor.native_handle())
+					Acceptable = true;
+				else
+					Silent.ready(Events[Event].data.fd, Batch);
+			}
+
+			if (Woken)
+			{
+				eventfd_t Value;
+				::eventfd_read(Wake, &Value);
+			}
+			if (Woken || !Acceptable || Full || CachedBatch == 0)
+			{
+				if (!Batch.empty())
+					publish(Batch);
+				continue;
+			}
+
+			int Error = 0;
+
+			for (std::size_t Accepted = 0; Accepted < CachedBatch; Accepted += 1)
+			{
+				sockaddr_storage Peer;
+				socklen_t PeerSize = sizeof(Peer);
+				const int Client = ::accept4(Acceptor.native_handle(), reinterpret_cast<sockaddr*>(&Peer), &PeerSize, SOCK_CLOEXEC);
+
+				if (Client == -1)
+				{
+					if (errno == EINTR || errno == ECONNABORTED)
+						continue;
+					Error = errno;
+					break;
 				}
+
+				net::entry Entry = make_entry(Client, CachedPort, Peer);
+
+				if (CachedPrefetch == 0 || Silent.take(Entry, CachedPrefetch))
+					Batch.push_back(Entry);
 			}
+
+			if (!Batch.empty())
+				publish(Batch);
+			// Out of descriptors or memory the socket stays readable, so it is not polled again at once
+			if (exhausted(Error))
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		{
+			std::lock_guard<std::mutex> AcceptorsLockGuard(AcceptorsMutex);
+			Acceptors[Index]->Listening = -1;
 		}
+		::close(Poller);
 	});
 }
 
-void net::queue::whileIsNotConstructed(void)
+std::vector<int> net::listener::descriptors(void)
 {
-	while (IsConstructed.load(std::memory_order_acquire))
-		continue;
+	std::lock_guard<std::mutex> AcceptorsLockGuard(AcceptorsMutex);
+	std::vector<int> Result;
+
+	for (auto& Acceptor : Acceptors)
+		if (Acceptor->Listening != -1)
+			if (const int Descriptor = ::fcntl(Acceptor->Listening, F_DUPFD_CLOEXEC, 0); Descriptor != -1)
+				Result.push_back(Descriptor);
+	return Result;
 }
 
-void net::queue::update(void)
+# ifdef NETORDERING_IO_URING
+bool net::listener::accept_uring(std::optional<net::uring>& Ring, boost::asio::ip::tcp::acceptor& Acceptor, const int Wake, const std::size_t CachedPort)
 {
-	if (Listeners.size() == 0)
-		Status.store(false, std::memory_order_release);
+	static constexpr std::uint64_t AcceptTag = 1;
+	static constexpr std::uint64_t WakeTag = 2;
+	static constexpr std::uint64_t CancelTag = 3;
 
-	std::lock_guard<std::mutex> ListenersProtectorLockGuard(ListenersProtector);
+	if (!Ring.has_value())
+		try
+		{
+			Ring.emplace(UringEntries);
+		}
+		catch (std::system_error const&)
+		{
+			return false;
+		}
 
-	bool Result = false;
-	for (auto& Listener : Listeners)
-		Result |= Listener->is_enabled();
+	io_uring_sqe* Accept = Ring->sqe();
+	io_uring_sqe* Poll = Ring->sqe();
 
-	Status.store(Result, std::memory_order_release);
+	// Ring is empty between calls, this is only a guard: the thread accepts by epoll on this wake-up
+	if (Accept == nullptr || Poll == nullptr)
+	{
+		if (!Ring->cancel([](io_uring_cqe const&) -> void { }))
+			Ring.reset();
+		return true;
+	}
+
+	Accept->opcode = IORING_OP_ACCEPT;
+	Accept->fd = Acceptor.native_handle();
+	Accept->ioprio = IORING_ACCEPT_MULTISHOT;
+	Accept->accept_flags = SOCK_CLOEXEC;
+	Accept->user_data = AcceptTag;
+
+	Poll->opcode = IORING_OP_POLL_ADD;
+	Poll->fd = Wake;
+	Poll->poll32_events = POLLIN;
+	Poll->user_data = WakeTag;
+
+	// Every completion of multishot accept would write to the same address, so entries of this path have only
+	// family of the listening socket. Address and port stay zero
+	sockaddr_storage Local = { };
+	socklen_t LocalSize = sizeof(Local);
+	sockaddr_storage Peer = { };
+
+	::getsockname(Acceptor.native_handle(), reinterpret_cast<sockaddr*>(&Local), &LocalSize);
+	Peer.ss_family = Local.ss_family == AF_INET6 ? AF_INET6 : AF_INET;
+
+	std::vector<net::entry> Batch;
+	bool Armed = true;
+	bool Waiting = true;
+	bool Cancelled = false;
+	bool Supported = true;
+	bool Failed = false;
+	std::size_t Accepted = 0;
+
+	const auto Collect = [&](io_uring_cqe const& Completion) -> void {
+		if (Completion.user_data == AcceptTag)
+		{
+			if (Completion.res >= 0)
+			{
+				Batch.push_back(make_entry(Completion.res, CachedPort, Peer));
+				Batch.back().uring = true;
+				Accepted += 1;
+			}
+			else if (Completion.res == -EINVAL && Accepted == 0)
+				Supported = false;
+			else if (exhausted(-Completion.res))
+				Failed = true;
+
+			if (!(Completion.flags & IORING_CQE_F_MORE))
+				Armed = false;
+		}
+		else if (Completion.user_data == WakeTag)
+			Waiting = false;
+	};
+
+	while (Armed || Waiting)
+	{
+		if (Ring->submit(1) < 0)
+		{
+			// Requests which stay armed would outlive this call and the socket, descriptors accepted
+			// before they are cancelled are still published
+			if (!Ring->cancel(Collect))
+				Ring.reset();
+			if (!Batch.empty())
+				publish(Batch);
+			Failed = true;
+			break;
+		}
+
+		Ring->reap(Collect);
+		if (!Batch.empty())
+			publish(Batch);
+
+		// Wake-up or the end of accept: cancel the other request, descriptors accepted meanwhile are still published
+		if (!Cancelled && Armed != Waiting)
+			if (io_uring_sqe* Cancel = Ring->sqe(); Cancel != nullptr)
+			{
+				Cancel->opcode = IORING_OP_ASYNC_CANCEL;
+				Cancel->addr = Armed ? AcceptTag : WakeTag;
+				Cancel->user_data = CancelTag;
+				Cancelled = true;
+			}
+	}
+
+	if (!Waiting)
+	{
+		eventfd_t Value;
+		::eventfd_read(Wake, &Value);
+	}
+	if (Failed && Supported)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	return Supported;
 }
+# endif
 
-bool net::queue::is_enabled(void) const
+[[ nodiscard ]]
+std::unique_ptr<net::connection> net::listener::pull_one(void)
 {
-	return Status.load(std::memory_order_relaxed);
+	while (std::optional<net::entry> Entry = Clients.pop())
+	{
+		release();
+		if (std::unique_ptr<net::connection> Result = net::connection::materialize(*Entry, *Contexts); Result != nullptr)
+			return Result;
+	}
+	return nullptr;
 }
 
 [[ nodiscard ]]
-std::unique_ptr<net::connection> net::queue::pull_one(void)
+std::unique_ptr<net::connection> net::listener::pull_one_wait(void)
 {
-	std::lock_guard<std::mutex> ThreadSafetyLockGuard(ThreadSafety);
-	std::lock_guard<std::mutex> QueueProtectorLockGuard(QueueProtector);
+	while (true)
+	{
+		std::unique_ptr<net::connection> Result = pull_one();
 
-	if (Queue.size() == 0)
-		return nullptr;
+		if (Result != nullptr || !Enabled.load(std::memory_order_acquire))
+			return Result;
+		Arrived.wait([this](void) -> bool { return ready(); });
+	}
+}
 
-	else
+[[ nodiscard ]]
+std::vector<std::unique_ptr<net::connection>> net::listener::pull_batch(const std::size_t Count)
+{
+	std::vector<std::unique_ptr<net::connection>> Result;
+
+	Result.reserve(std::min(Count, Clients.size()));
+	while (Result.size() < Count)
 	{
-		std::unique_ptr<net::connection> Result = std::move(Queue.front());
-		Queue.pop();
-		return Result;
+		std::optional<net::entry> Entry = Clients.pop();
+
+		if (!Entry.has_value())
+			break;
+		if (std::unique_ptr<net::connection> Connection = net::connection::materialize(*Entry, *Contexts); Connection != nullptr)
+			Result.push_back(std::move(Connection));
 	}
+	release();
+	return Result;
 }
 
-void net::queue::enable(void)
+std::vector<net::entry> net::listener::pull_entries(const std::size_t Count)
 {
-	std::lock_guard<std::mutex> ThreadSafetyLockGuard(ThreadSafety);
-	ListenersProtector.lock();
+	std::vector<net::entry> Result;
 
-	for (auto& Listener : Listeners)
-		Listener->enable();
+	Result.reserve(std::min(Count, Clients.size()));
+	while (Result.size() < Count)
+	{
+		std::optional<net::entry> Entry = Clients.pop();
 
-	ListenersProtector.unlock();
-	update();
+		if (!Entry.has_value())
+			break;
+		Result.push_back(*Entry);
+	}
+	release();
+	return Result;
 }
 
-void net::queue::disable(void)
+void net::listener::release(void)
 {
-	std::lock_guard<std::mutex> ThreadSafetyLockGuard(ThreadSafety);
-	ListenersProtector.lock();
+	if (Backlogged.load(std::memory_order_relaxed) && Backlogged.exchange(false, std::memory_order_acq_rel))
+		wake();
+}
 
-	for (auto& Listener : Listeners)
-		Listener->disable();
+std::shared_ptr<const net::rejection_policy> net::listener::policy(void)
+{
+	std::shared_ptr<const net::listener_config> Cached = Config.load(std::memory_order_acquire);
 
-	ListenersProtector.unlock();
-	update();
+	return std::shared_ptr<const net::rejection_policy>(Cached, &Cached->rejection);
 }
 
-std::size_t net::queue::size(void)
+std::shared_ptr<const net::listener_config> net::listener::configure(const std::size_t __Port, const std::size_t __Limit)
 {
-	std::lock_guard<std::mutex> ThreadSafetyLockGuard(ThreadSafety);
-	std::lock_guard<std::mutex> QueueProtectorLockGuard(QueueProtector);
+	std::shared_ptr<net::listener_config> Result = std::make_shared<net::listener_config>();
 
-	return Queue.size();
+	Result->port = __Port;
+	Result->limit = __Limit;
+	return Result;
 }
 
-std::size_t net::queue::get_limit_order(void)
+std::shared_ptr<const net::listener_config> net::listener::get_config(void) const
 {
-	return LimitOrder.load(std::memory_order_relaxed);
+	return Config.load(std::memory_order_acquire);
 }
 
-void net::listener::whileIsNotConstructed(void)
+void net::listener::set_config(net::listener_config Next)
 {
-	while (!IsConstructed.load(std::memory_order_acquire))
-		continue;
+	std::lock_guard<std::mutex> LockGuard(ThreadSafety);
+
+	if (Config.load(std::memory_order_acquire)->port != Next.port)
+		bind_all(Next.port);
+	Next.kind = available(Next.kind);
+	Next.accept_batch = std::max<std::size_t>(Next.accept_batch, 1);
+	Next.prefetch = std::max(Next.prefetch, std::chrono::nanoseconds(0));
+	Clients.reserve(Next.limit);
+	Config.store(std::make_shared<const net::listener_config>(std::move(Next)), std::memory_order_release);
+	wake();
 }
 
-void net::listener::launch(void)
+void net::listener::set_rejection(const net::rejection Kind)
 {
-	std::lock_guard<std::mutex> LockGuard(ThreadSafety);
+	reconfigure([Kind](net::listener_config& Next) -> void {
+		Next.rejection.kind = Kind;
+	});
+}
 
-	Listener = std::thread([&](void) -> void {
-		boost::asio::io_service IO_ServiceAcceptor;
-		std::size_t CachedLimit = Limit.load(std::memory_order_acquire);
+void net::listener::set_rejection(net::rejection_policy Policy)
+{
+	reconfigure([&Policy](net::listener_config& Next) -> void {
+		Next.rejection = Policy;
+	});
+}
 
-		IsConstructed.store(true, std::memory_order_seq_cst);
-		while (Enabled.load(std::memory_order_acquire))
-		{
-			EnabledMutex.lock();
-			IsLocked.store(true, std::memory_order_seq_cst);
+net::rejection net::listener::get_rejection(void) const
+{
+	return Config.load(std::memory_order_relaxed)->rejection.kind;
+}
 
-			std::unique_ptr<net::connection> Connection = std::make_unique<net::connection>(Port.load(std::memory_order_acquire));
-			Connection->ios = std::make_unique<boost::asio::io_service>();
-			Connection->socket = std::make_unique<boost::asio::ip::tcp::socket>(*Connection->ios);
+void net::listener::set_backend(const net::backend Kind)
+{
+	reconfigure([Kind = available(Kind)](net::listener_config& Next) -> void {
+		Next.kind = Kind;
+	});
+}
 
-			boost::asio::ip::tcp::endpoint EndPoint(boost::asio::ip::tcp::v4(), static_cast<boost::asio::ip::port_type>(Connection->port));
+net::backend net::listener::get_backend(void) const
+{
+	return Config.load(std::memory_order_relaxed)->kind;
+}
 
-			boost::asio::ip::tcp::acceptor Acceptor(IO_ServiceAcceptor, EndPoint);
-			Acceptor.accept(*Connection->socket);
+net::port_metrics net::listener::snapshot(void)
+{
+	std::shared_ptr<const net::listener_config> Cached = Config.load(std::memory_order_relaxed);
+	net::port_metrics Result;
 
-			std::lock_guard<std::mutex> LockGuard(ClientsMutex);
-			CachedLimit = Limit.load(std::memory_order_seq_cst);
+	Result.port = Cached->port;
+	Result.accepted = Counters.accepted.load(std::memory_order_relaxed);
+	for (std::size_t Index = 0; Index < Result.rejected.size(); Index += 1)
+		Result.rejected[Index] = Counters.rejected[Index].load(std::memory_order_relaxed);
+	Result.depth = Clients.size();
+	Result.limit = Cached->limit;
 
-			if (CachedLimit == 0 || Clients.size() < CachedLimit)
-				Clients.push(std::move(Connection));
-			else
-			{
-				boost::asio::write(*Connection->socket, boost::asio::buffer(ErrorMessage.data(), ErrorMessage.size()));
-			
-				Connection->socket->close();
-			}
-			EnabledMutex.unlock();
-			IsLocked.store(false, std::memory_order_seq_cst);
-		}
-	});
+	return Result;
 }
 
-[[ nodiscard ]]
-std::unique_ptr<net::connection> net::listener::pull_one(void)
+bool net::listener::ready(void)
 {
-	std::lock_guard<std::mutex> LockGuard(ThreadSafety);
-	std::lock_guard<std::mutex> __LockGuard(ClientsMutex);
+	return !Clients.empty() || !Enabled.load(std::memory_order_acquire);
+}
 
-	if (Clients.size() == 0)
-		return nullptr;
-	else
-	{
-		std::unique_ptr<net::connection> Result = std::move(Clients.front());
+void net::listener::observe(net::notifier* __Observer)
+{
+	Observer.store(__Observer, std::memory_order_release);
+}
 
-		Clients.pop();
-		return Result;
-	}
+void net::listener::share(net::token_bucket* __Shared)
+{
+	Shared.store(__Shared, std::memory_order_release);
+}
+
+void net::listener::route(net::rejector* __Routed)
+{
+	Routed.store(__Routed, std::memory_order_release);
+}
+
+std::size_t net::listener::get_rate(void) const
+{
+	return Bucket.get_rate();
+}
+
+std::size_t net::listener::get_burst(void) const
+{
+	return Bucket.get_burst();
 }
 
 bool net::listener::is_enabled(void) const
 {
-	return !Sleep;
+	return !Sleep.load(std::memory_order_relaxed);
 }
 
 std::size_t net::listener::size(void)
 {
-	std::lock_guard<std::mutex> LockGuard(ThreadSafety);
-	std::lock_guard<std::mutex> __LockGuard(ClientsMutex);
-
 	return Clients.size();
 }
 
 std::size_t net::listener::get_limit(void)
 {
-	std::lock_guard<std::mutex> LockGuard(ThreadSafety);
-
-	return Limit.load(std::memory_order_relaxed);
+	return Config.load(std::memory_order_relaxed)->limit;
 }
 
 void net::listener::enable(void)
 {
 	std::lock_guard<std::mutex> LockGuard(ThreadSafety);
 
-	if (Sleep)
 	{
-		while (!IsLocked.load(std::memory_order_acquire))
-			continue;
-
-		EnabledMutex.unlock();
-		IsLocked.store(false, std::memory_order_seq_cst);
-		Sleep = false;
+		std::lock_guard<std::mutex> SleepLockGuard(SleepMutex);
+		Sleep.store(false, std::memory_order_seq_cst);
 	}
+	SleepCondition.notify_all();
 }
 
 void net::listener::disable(void)
 {
 	std::lock_guard<std::mutex> LockGuard(ThreadSafety);
 
-	if (!Sleep)
 	{
-		while (IsLocked.load(std::memory_order_acquire))
-			continue;
-
-		EnabledMutex.lock();
-		IsLocked.store(true, std::memory_order_seq_cst);
-		Sleep = true;
+		std::lock_guard<std::mutex> SleepLockGuard(SleepMutex);
+		Sleep.store(true, std::memory_order_seq_cst);
 	}
+	wake();
 }
 
-std::size_t net::listener::get_port(void)
+std::size_t net::listener::get_acceptors(void) const
 {
-	std::lock_guard<std::mutex> LockGuard(ThreadSafety);
+	return AcceptorsCount.load(std::memory_order_relaxed);
+}
+
+std::size_t net::listener::get_accept_batch(void) const
+{
+	return Config.load(std::memory_order_relaxed)->accept_batch;
+}
 
-	return Port.load(std::memory_order_relaxed);
+std::size_t net::listener::get_port(void)
+{
+	return Config.load(std::memory_order_relaxed)->port;
 }
\ No newline at end of file
@@ -0,0 +1,230 @@
+# include <netordering/net.hpp>
+
+# include <sys/eventfd.h>
+# include <sys/epoll.h>
+# include <sys/socket.h>
+# include <system_error>
+# include <unistd.h>
+
+static std::int64_t parking_now(void)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+net::parking::parking(std::function<void(std::unique_ptr<net::connection>)> __Dispatch) : Poller(::epoll_create1(EPOLL_CLOEXEC)),
+	Wake(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+	Enabled(true),
+	Closing(false),
+	IdleTimeout(60000000000),
+	Count(0),
+	Dispatch(std::move(__Dispatch))
+{
+	if (Poller == -1 || Wake == -1)
+	{
+		const int Error = errno;
+
+		if (Poller != -1)
+			::close(Poller);
+		if (Wake != -1)
+			::close(Wake);
+		throw std::system_error(Error, std::generic_category(), "parking");
+	}
+
+	epoll_event Event = { };
+	Event.events = EPOLLIN;
+	Event.data.fd = Wake;
+	::epoll_ctl(Poller, EPOLL_CTL_ADD, Wake, &Event);
+}
+
+net::parking::~parking(void)
+{
+	Enabled.store(false, std::memory_order_seq_cst);
+	::eventfd_write(Wake, 1);
+
+	if (Thread.joinable())
+		Thread.join();
+
+	Parked.clear();
+	::close(Poller);
+	::close(Wake);
+}
+
+void net::parking::park(std::unique_ptr<net::connection> Connection)
+{
+	if (Connection == nullptr || !Connection->socket.has_value() || !Connection->socket->is_open())
+		return;
+
+	std::call_once(Started, [this](void) -> void {
+		Thread = std::thread(&net::parking::work, this);
+	});
+
+	const int Descriptor = Connection->socket->native_handle();
+	const std::int64_t Deadline = parking_now() + IdleTimeout.load(std::memory_order_relaxed);
+	bool Woken = false;
+
+	{
+		std::lock_guard<std::mutex> LockGuard(Mutex);
+
+		// Connection is closed by its destructor after the lock
+		if (Closing.load(std::memory_order_acquire))
+			return;
+
+		Woken = Deadlines.empty() || Deadline < Deadlines.begin()->first;
+		Parked[Descriptor] = parked{ std::move(Connection), Deadlines.emplace(Deadline, Descriptor) };
+
+		// One-shot, so the connection is reported once and the worker owns it alone
+		epoll_event Event = { };
+		Event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+		Event.data.fd = Descriptor;
+
+		if (::epoll_ctl(Poller, EPOLL_CTL_ADD, Descriptor, &Event) != 0 && ::epoll_ctl(Poller, EPOLL_CTL_MOD, Descriptor, &Event) != 0)
+		{
+			parked& Entry = Parked[Descriptor];
+
+			Connection = std::move(Entry.Connection);
+			Deadlines.erase(Entry.Deadline);
+			Parked.erase(Descriptor);
+			return;
+		}
+		Count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Parking thread sleeps until the nearest deadline, it is recomputed for a nearer one
+	if (Woken)
+		::eventfd_write(Wake, 1);
+}
+
+void net::park(std::unique_ptr<net::connection> Connection)
+{
+	if (Connection == nullptr)
+		return;
+	if (std::shared_ptr<net::parking> Parking = Connection->Parking.lock(); Parking != nullptr)
+		Parking->park(std::move(Connection));
+}
+
+void net::parking::set_timeout(const std::int64_t Timeout)
+{
+	IdleTimeout.store(Timeout, std::memory_order_relaxed);
+	::eventfd_write(Wake, 1);
+}
+
+std::int64_t net::parking::get_timeout(void) const
+{
+	return IdleTimeout.load(std::memory_order_relaxed);
+}
+
+std::size_t net::parking::size(void) const
+{
+	return Count.load(std::memory_order_relaxed);
+}
+
+void net::parking::close(void)
+{
+	std::vector<std::unique_ptr<net::connection>> Closed;
+
+	Closing.store(true, std::memory_order_seq_cst);
+	{
+		std::lock_guard<std::mutex> LockGuard(Mutex);
+
+		Closed.reserve(Parked.size());
+		for (auto& [Descriptor, Entry] : Parked)
+		{
+			::epoll_ctl(Poller, EPOLL_CTL_DEL, Descriptor, nullptr);
+			Closed.push_back(std::move(Entry.Connection));
+		}
+		Parked.clear();
+		Deadlines.clear();
+		Count.store(0, std::memory_order_relaxed);
+	}
+	// Waits for the connection which is being dispatched, if there is one
+	std::lock_guard<std::mutex> DispatchingLockGuard(Dispatching);
+
+	::eventfd_write(Wake, 1);
+}
+
+void net::parking::work(void)
+{
+	std::array<epoll_event, 64> Events;
+
+	while (Enabled.load(std::memory_order_acquire))
+	{
+		const int Ready = ::epoll_wait(Poller, Events.data(), static_cast<int>(Events.size()), expire());
+
+		for (int Index = 0; Index < Ready; Index += 1)
+		{
+			if (Events[Index].data.fd == Wake)
+			{
+				eventfd_t Value;
+				::eventfd_read(Wake, &Value);
+				continue;
+			}
+			resume(Events[Index].data.fd, Events[Index].events);
+		}
+	}
+}
+
+int net::parking::expire(void)
+{
+	const std::int64_t Now = parking_now();
+	std::vector<std::unique_ptr<net::connection>> Expired;
+	int Result = -1;
+
+	{
+		std::lock_guard<std::mutex> LockGuard(Mutex);
+
+		while (!Deadlines.empty())
+		{
+			const deadlines::iterator Front = Deadlines.begin();
+
+			if (Front->first > Now)
+			{
+				Result = static_cast<int>(std::min<std::int64_t>((Front->first - Now) / 1000000 + 1, std::numeric_limits<int>::max()));
+				break;
+			}
+
+			std::unordered_map<int, parked>::iterator Iterator = Parked.find(Front->second);
+
+			::epoll_ctl(Poller, EPOLL_CTL_DEL, Front->second, nullptr);
+			Expired.push_back(std::move(Iterator->second.Connection));
+			Parked.erase(Iterator);
+			Deadlines.erase(Front);
+		}
+		Count.fetch_sub(Expired.size(), std::memory_order_relaxed);
+	}
+	return Result;
+}
+
+void net::parking::resume(const int Descriptor, const std::uint32_t Events)
+{
+	std::unique_ptr<net::connection> Connection;
+
+	{
+		std::lock_guard<std::mutex> LockGuard(Mutex);
+		std::unordered_map<int, parked>::iterator Iterator = Parked.find(Descriptor);
+
+		if (Iterator == Parked.end())
+			return;
+
+		::epoll_ctl(Poller, EPOLL_CTL_DEL, Descriptor, nullptr);
+		Connection = std::move(Iterator->second.Connection);
+		Deadlines.erase(Iterator->second.Deadline);
+		Parked.erase(Iterator);
+		Count.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	// Peer may have sent the last request and closed, so hang-up is closed only if nothing is left to read
+	if (Events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+	{
+		char Byte;
+
+		if (::recv(Descriptor, &Byte, 1, MSG_PEEK | MSG_DONTWAIT) <= 0)
+			return;
+	}
+
+	std::lock_guard<std::mutex> DispatchingLockGuard(Dispatching);
+
+	// Owner of Dispatch may be destroyed after close(), connection is closed by its destructor then
+	if (Closing.load(std::memory_order_acquire))
+		return;
+	Dispatch(std::move(Connection));
+}
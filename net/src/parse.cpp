@@ -0,0 +1,347 @@
+# include <netordering/http.hpp>
+
+# include <algorithm>
+# include <optional>
+# include <cstring>
+# include <limits>
+# include <atomic>
+
+# if defined(__x86_64__) || defined(__i386__)
+#	include <immintrin.h>
+#	define NETORDERING_HTTP_X86
+# endif
+
+/*
+*	tchar of RFC 9110: characters of method and header name
+*/
+static constexpr std::array<bool, 256> Token = [](void) -> std::array<bool, 256> {
+	std::array<bool, 256> Result = { };
+
+	for (unsigned Character = '0'; Character <= '9'; Character += 1)
+		Result[Character] = true;
+	for (unsigned Character = 'a'; Character <= 'z'; Character += 1)
+		Result[Character] = Result[Character - 'a' + 'A'] = true;
+	for (const char Character : std::string_view("!#$%&'*+-.^_`|~"))
+		Result[static_cast<unsigned char>(Character)] = true;
+	return Result;
+}();
+
+/*
+*	First byte from Begin which is Stop or a control character(except tab), End if there is none.
+*	Bytes from 0x80 are allowed, they are obs-text of header values
+*/
+static char const* find_scalar(char const* Begin, char const* End, const char Stop)
+{
+	for (; Begin != End; Begin += 1)
+	{
+		const unsigned char Byte = static_cast<unsigned char>(*Begin);
+
+		if (Byte == static_cast<unsigned char>(Stop) || (Byte < 0x20 && Byte != '\t') || Byte == 0x7f)
+			return Begin;
+	}
+	return End;
+}
+
+# ifdef NETORDERING_HTTP_X86
+__attribute__((target("sse4.2")))
+static char const* find_sse42(char const* Begin, char const* End, const char Stop)
+{
+	// Pairs of ranges for pcmpestri: 0x00-0x08, 0x0a-0x1f, 0x7f and Stop
+	const __m128i Ranges = _mm_setr_epi8(0x00, 0x08, 0x0a, 0x1f, 0x7f, 0x7f, Stop, Stop, 0, 0, 0, 0, 0, 0, 0, 0);
+
+	while (End - Begin >= 16)
+	{
+		const __m128i Data = _mm_loadu_si128(reinterpret_cast<__m128i const*>(Begin));
+		const int Index = _mm_cmpestri(Ranges, 8, Data, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT);
+
+		if (Index != 16)
+			return Begin + Index;
+		Begin += 16;
+	}
+	return find_scalar(Begin, End, Stop);
+}
+
+__attribute__((target("avx2")))
+static char const* find_avx2(char const* Begin, char const* End, const char Stop)
+{
+	const __m256i Space = _mm256_set1_epi8(0x20);
+	const __m256i Tab = _mm256_set1_epi8('\t');
+	const __m256i Delete = _mm256_set1_epi8(0x7f);
+	const __m256i Negative = _mm256_set1_epi8(-1);
+	const __m256i Target = _mm256_set1_epi8(Stop);
+
+	while (End - Begin >= 32)
+	{
+		const __m256i Data = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(Begin));
+
+		// Comparison is signed, so bytes from 0x80 are negative and are excluded from controls
+		__m256i Hit = _mm256_and_si256(_mm256_cmpgt_epi8(Space, Data), _mm256_cmpgt_epi8(Data, Negative));
+
+		Hit = _mm256_andnot_si256(_mm256_cmpeq_epi8(Data, Tab), Hit);
+		Hit = _mm256_or_si256(Hit, _mm256_cmpeq_epi8(Data, Delete));
+		Hit = _mm256_or_si256(Hit, _mm256_cmpeq_epi8(Data, Target));
+
+		if (const unsigned Mask = static_cast<unsigned>(_mm256_movemask_epi8(Hit)); Mask != 0)
+			return Begin + __builtin_ctz(Mask);
+		Begin += 32;
+	}
+	return find_scalar(Begin, End, Stop);
+}
+# endif
+
+using finder = char const* (*)(char const*, char const*, const char);
+
+static bool has(const net::scan Kind)
+{
+# ifdef NETORDERING_HTTP_X86
+	__builtin_cpu_init();
+	if (Kind == net::scan::avx2)
+		return __builtin_cpu_supports("avx2");
+	if (Kind == net::scan::sse42)
+		return __builtin_cpu_supports("sse4.2");
+# endif
+	return Kind == net::scan::scalar;
+}
+
+static finder finder_of(const net::scan Kind)
+{
+	switch (Kind)
+	{
+# ifdef NETORDERING_HTTP_X86
+		case net::scan::avx2:
+			return find_avx2;
+		case net::scan::sse42:
+			return find_sse42;
+# endif
+		default:
+			return find_scalar;
+	}
+}
+
+static net::scan select_scan(void)
+{
+	for (const net::scan Kind : { net::scan::avx2, net::scan::sse42 })
+		if (has(Kind))
+			return Kind;
+	return net::scan::scalar;
+}
+
+static std::atomic<net::scan> Scan = select_scan();
+
+static bool same(const std::string_view Left, const std::string_view Right)
+{
+	if (Left.size() != Right.size())
+		return false;
+	for (std::size_t Index = 0; Index < Left.size(); Index += 1)
+		if ((Left[Index] | 0x20) != (Right[Index] | 0x20))
+			return false;
+	return true;
+}
+
+static bool token(char const* Begin, char const* End)
+{
+	for (; Begin != End; Begin += 1)
+		if (!Token[static_cast<unsigned char>(*Begin)])
+			return false;
+	return true;
+}
+
+/*
+*	Whether comma-separated Value has Item(case-insensitive), e.g. "keep-alive, Upgrade"
+*/
+static bool listed(std::string_view Value, const std::string_view Item)
+{
+	while (!Value.empty())
+	{
+		const std::size_t Comma = std::min(Value.find(','), Value.size());
+		std::string_view Element = Value.substr(0, Comma);
+
+		while (!Element.empty() && (Element.front() == ' ' || Element.front() == '\t'))
+			Element.remove_prefix(1);
+		while (!Element.empty() && (Element.back() == ' ' || Element.back() == '\t'))
+			Element.remove_suffix(1);
+		if (same(Element, Item))
+			return true;
+		Value.remove_prefix(std::min(Comma + 1, Value.size()));
+	}
+	return false;
+}
+
+/*
+*	Skips "\r\n" or bare "\n" at Current
+*/
+static net::framing line_end(char const*& Current, char const* End)
+{
+	if (*Current == '\r')
+	{
+		Current += 1;
+		if (Current == End)
+			return net::framing::partial;
+		if (*Current != '\n')
+			return net::framing::invalid;
+	}
+	else if (*Current != '\n')
+		return net::framing::invalid;
+
+	Current += 1;
+	return net::framing::complete;
+}
+
+bool net::set_scan(const net::scan Kind)
+{
+	if (!has(Kind))
+		return false;
+
+	Scan.store(Kind, std::memory_order_relaxed);
+
+	return true;
+}
+
+net::scan net::get_scan(void)
+{
+	return Scan.load(std::memory_order_relaxed);
+}
+
+std::string_view net::request_view::header(const std::string_view Name) const
+{
+	for (std::size_t Index = 0; Index < header_count; Index += 1)
+		if (same(headers[Index].name, Name))
+			return headers[Index].value;
+	return std::string_view();
+}
+
+net::framing net::parse(const std::string_view Data, net::request_view& Request)
+{
+	char const* const Begin = Data.data();
+	char const* const End = Begin + Data.size();
+	char const* Current = Begin;
+	char const* Stop;
+	const finder Find = finder_of(Scan.load(std::memory_order_relaxed));
+
+	Request.size = 0;
+
+	// Empty lines before the request line are ignored(RFC 9112 2.2)
+	while (Current != End && (*Current == '\r' || *Current == '\n'))
+		Current += 1;
+
+	Stop = Find(Current, End, ' ');
+	if (Stop == End)
+		return net::framing::partial;
+	if (*Stop != ' ' || Stop == Current || !token(Current, Stop))
+		return net::framing::invalid;
+	Request.method = std::string_view(Current, Stop - Current);
+	Current = Stop + 1;
+
+	Stop = Find(Current, End, ' ');
+	if (Stop == End)
+		return net::framing::partial;
+	if (*Stop != ' ' || Stop == Current)
+		return net::framing::invalid;
+	Request.target = std::string_view(Current, Stop - Current);
+	Current = Stop + 1;
+
+	static constexpr std::string_view Version = "HTTP/1.";
+
+	if (static_cast<std::size_t>(End - Current) <= Version.size())
+		return std::memcmp(Current, Version.data(), End - Current) == 0 ? net::framing::partial : net::framing::invalid;
+	if (std::memcmp(Current, Version.data(), Version.size()) != 0 || Current[Version.size()] < '0' || Current[Version.size()] > '9')
+		return net::framing::invalid;
+	Request.minor_version = Current[Version.size()] - '0';
+	Current += Version.size() + 1;
+	if (Current == End)
+		return net::framing::partial;
+	if (const net::framing Result = line_end(Current, End); Result != net::framing::complete)
+		return Result;
+
+	Request.header_count = 0;
+	while (true)
+	{
+		if (Current == End)
+			return net::framing::partial;
+		if (*Current == '\r' || *Current == '\n')
+		{
+			if (const net::framing Result = line_end(Current, End); Result != net::framing::complete)
+				return Result;
+			break;
+		}
+		if (Request.header_count == net::request_view::MaxHeaders)
+			return net::framing::too_large;
+
+		net::header& Header = Request.headers[Request.header_count];
+
+		Stop = Find(Current, End, ':');
+		if (Stop == End)
+			return net::framing::partial;
+		if (*Stop != ':' || Stop == Current || !token(Current, Stop))
+			return net::framing::invalid;
+		Header.name = std::string_view(Current, Stop - Current);
+		Current = Stop + 1;
+
+		while (Current != End && (*Current == ' ' || *Current == '\t'))
+			Current += 1;
+
+		// '\r' is a control character itself, so any of them stops the value
+		Stop = Find(Current, End, '\r');
+		if (Stop == End)
+			return net::framing::partial;
+		if (*Stop != '\r' && *Stop != '\n')
+			return net::framing::invalid;
+
+		char const* Last = Stop;
+
+		while (Last != Current && (Last[-1] == ' ' || Last[-1] == '\t'))
+			Last -= 1;
+		Header.value = std::string_view(Current, Last - Current);
+		Current = Stop;
+		if (const net::framing Result = line_end(Current, End); Result != net::framing::complete)
+			return Result;
+		Request.header_count += 1;
+	}
+
+	std::optional<std::size_t> Length;
+	bool Persistent = Request.minor_version >= 1;
+
+	for (std::size_t Index = 0; Index < Request.header_count; Index += 1)
+	{
+		net::header const& Header = Request.headers[Index];
+
+		if (same(Header.name, "Content-Length"))
+		{
+			if (Header.value.empty())
+				return net::framing::invalid;
+
+			std::size_t Value = 0;
+
+			for (const char Digit : Header.value)
+			{
+				if (Digit < '0' || Digit > '9' || Value > (std::numeric_limits<std::size_t>::max() - 9) / 10)
+					return net::framing::invalid;
+				Value = Value * 10 + static_cast<std::size_t>(Digit - '0');
+			}
+			// Different lengths make request smuggling possible
+			if (Length.has_value() && *Length != Value)
+				return net::framing::invalid;
+			Length = Value;
+		}
+		else if (same(Header.name, "Transfer-Encoding"))
+			return net::framing::unsupported;
+		else if (same(Header.name, "Connection"))
+		{
+			if (listed(Header.value, "close"))
+				Persistent = false;
+			else if (listed(Header.value, "keep-alive"))
+				Persistent = true;
+		}
+	}
+
+	const std::size_t Body = Length.value_or(0);
+
+	// Size which is over the address space can not be in any buffer, the caller answers it as too large
+	Request.size = Body <= std::numeric_limits<std::size_t>::max() - static_cast<std::size_t>(Current - Begin) ? static_cast<std::size_t>(Current - Begin) + Body : std::numeric_limits<std::size_t>::max();
+	if (static_cast<std::size_t>(End - Current) < Body)
+		return net::framing::partial;
+	Request.body = std::string_view(Current, Body);
+	Request.keep_alive = Persistent;
+	return net::framing::complete;
+}
+
@@ -0,0 +1,224 @@
+# include <netordering/payload.hpp>
+
+# include <algorithm>
+# include <stdexcept>
+# include <cstring>
+# include <vector>
+# include <mutex>
+
+# include <sys/stat.h>
+# include <fcntl.h>
+# include <unistd.h>
+
+static constexpr std::size_t BufferCacheSize = 32;
+static constexpr std::size_t BufferPoolSize = 1024;
+
+static std::mutex& buffer_pool_mutex(void)
+{
+	static std::mutex Mutex;
+
+	return Mutex;
+}
+
+static std::vector<char*>& buffer_pool(void)
+{
+	static std::vector<char*> Pool;
+
+	return Pool;
+}
+
+struct buffer_cache final
+{
+	std::vector<char*> Blocks;
+
+	~buffer_cache(void)
+	{
+		std::lock_guard<std::mutex> LockGuard(buffer_pool_mutex());
+
+		for (char* Block : Blocks)
+			if (buffer_pool().size() < BufferPoolSize)
+				buffer_pool().push_back(Block);
+			else
+				delete[] Block;
+	}
+};
+
+static buffer_cache& local_buffer_cache(void)
+{
+	thread_local buffer_cache Cache;
+
+	return Cache;
+}
+
+static char* take_block(void)
+{
+	std::vector<char*>& Blocks = local_buffer_cache().Blocks;
+
+	if (Blocks.empty())
+	{
+		std::lock_guard<std::mutex> LockGuard(buffer_pool_mutex());
+		std::vector<char*>& Pool = buffer_pool();
+
+		while (!Pool.empty() && Blocks.size() < BufferCacheSize / 2)
+		{
+			Blocks.push_back(Pool.back());
+			Pool.pop_back();
+		}
+	}
+
+	if (Blocks.empty())
+		return new char[net::buffer::Capacity];
+
+	char* Result = Blocks.back();
+	Blocks.pop_back();
+	return Result;
+}
+
+static void give_block(char* Block)
+{
+	std::vector<char*>& Blocks = local_buffer_cache().Blocks;
+
+	Blocks.push_back(Block);
+	if (Blocks.size() > BufferCacheSize)
+	{
+		std::lock_guard<std::mutex> LockGuard(buffer_pool_mutex());
+		std::vector<char*>& Pool = buffer_pool();
+
+		while (Blocks.size() > BufferCacheSize / 2)
+		{
+			if (Pool.size() < BufferPoolSize)
+				Pool.push_back(Blocks.back());
+			else
+				delete[] Blocks.back();
+			Blocks.pop_back();
+		}
+	}
+}
+
+net::buffer::buffer(void) : Data(take_block()), Size(0)
+{ }
+
+net::buffer::buffer(char* Block, const std::size_t __Size) : Data(Block), Size(Block == nullptr ? 0 : std::min(__Size, Capacity))
+{ }
+
+net::buffer::buffer(net::buffer&& Other) noexcept : Data(Other.Data), Size(Other.Size)
+{
+	Other.Data = nullptr;
+	Other.Size = 0;
+}
+
+net::buffer& net::buffer::operator=(net::buffer&& Other) noexcept
+{
+	if (this != &Other)
+	{
+		release();
+		Data = Other.Data;
+		Size = Other.Size;
+		Other.Data = nullptr;
+		Other.Size = 0;
+	}
+	return *this;
+}
+
+net::buffer::~buffer(void)
+{
+	release();
+}
+
+char* net::buffer::data(void)
+{
+	return Data;
+}
+
+char const* net::buffer::data(void) const
+{
+	return Data;
+}
+
+std::size_t net::buffer::size(void) const
+{
+	return Size;
+}
+
+std::size_t net::buffer::capacity(void) const
+{
+	return Data == nullptr ? 0 : Capacity;
+}
+
+void net::buffer::resize(const std::size_t __Size)
+{
+	Size = std::min(__Size, capacity());
+}
+
+std::size_t net::buffer::append(const std::string_view Text)
+{
+	const std::size_t Count = std::min(Text.size(), capacity() - Size);
+
+	std::memcpy(Data + Size, Text.data(), Count);
+	Size += Count;
+
+	return Count;
+}
+
+std::string_view net::buffer::view(void) const
+{
+	return std::string_view(Data, Size);
+}
+
+char* net::buffer::detach(void)
+{
+	char* Result = Data;
+
+	Data = nullptr;
+	Size = 0;
+	return Result;
+}
+
+void net::buffer::recycle(char* Block)
+{
+	if (Block != nullptr)
+		give_block(Block);
+}
+
+void net::buffer::release(void)
+{
+	if (Data != nullptr)
+		give_block(Data);
+	Data = nullptr;
+	Size = 0;
+}
+
+net::file::file(std::string const& Path) : Descriptor(::open(Path.c_str(), O_RDONLY | O_CLOEXEC)), Size(0)
+{
+	struct stat Status;
+
+	if (Descriptor == -1 || ::fstat(Descriptor, &Status) != 0)
+	{
+		if (Descriptor != -1)
+			::close(Descriptor);
+		throw std::runtime_error("Can not open " + Path);
+	}
+	Size = static_cast<std::size_t>(Status.st_size);
+}
+
+net::file::file(net::file&& Other) noexcept : Descriptor(Other.Descriptor), Size(Other.Size)
+{
+	Other.Descriptor = -1;
+	Other.Size = 0;
+}
+
+net::file::~file(void)
+{
+	if (Descriptor != -1)
+		::close(Descriptor);
+}
+
+int net::file::descriptor(void) const
+{
+	return Descriptor;
+}
+
+std::size_t net::file::size(void) const
+{
+	return Size;
+}
@@ -0,0 +1,122 @@
+# include <netordering/net.hpp>
+
+# include <sys/socket.h>
+# include <unistd.h>
+
+net::rejector::rejector(void) : rejector(context_pool::shared())
+{ }
+
+net::rejector::rejector(std::shared_ptr<net::context_pool> __Contexts) : Stopping(false), Order(1024), Contexts(std::move(__Contexts))
+{
+	Thread = std::thread(&net::rejector::work, this);
+}
+
+net::rejector::~rejector(void)
+{
+	Stopping.store(true, std::memory_order_seq_cst);
+	Pending.notify_all();
+
+	if (Thread.joinable())
+		Thread.join();
+
+	while (std::optional<rejected> Rejected = Order.pop())
+		reset(Rejected->Entry);
+}
+
+bool net::rejector::reject(net::entry const& Entry, std::shared_ptr<const net::rejection_policy> const& Policy)
+{
+	rejected Rejected{ Entry, Policy };
+
+	if (!Order.try_push(Rejected, MaxPending))
+	{
+		reset(Entry);
+		return false;
+	}
+	Pending.notify_one();
+	return true;
+}
+
+std::size_t net::rejector::size(void) const
+{
+	return Order.size();
+}
+
+std::shared_ptr<net::rejector> net::rejector::shared(void)
+{
+	static std::shared_ptr<net::rejector> Rejector = std::make_shared<net::rejector>();
+
+	return Rejector;
+}
+
+void net::rejector::work(void)
+{
+	while (true)
+	{
+		const std::size_t Epoch = Pending.epoch();
+
+		while (std::optional<rejected> Rejected = Order.pop())
+			apply(Rejected->Entry, Rejected->Policy);
+
+		if (Stopping.load(std::memory_order_acquire))
+			return;
+
+		Pending.wait([&](void) -> bool {
+			return Pending.epoch() != Epoch || Stopping.load(std::memory_order_acquire);
+		});
+	}
+}
+
+void net::rejector::apply(net::entry const& Entry, std::shared_ptr<const net::rejection_policy> const& Policy)
+{
+	switch (Policy->kind)
+	{
+		case rejection::message:
+			send(Entry, Policy->message);
+			break;
+		case rejection::unavailable:
+			send(Entry, "HTTP/1.1 503 Service Unavailable\r\nRetry-After: " + std::to_string(Policy->retry_after)
+				+ "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+			break;
+		case rejection::callback:
+			if (Policy->handler != nullptr)
+			{
+				// Handler runs on io_context of the connection, a slow one does not hold up the other rejections
+				if (std::unique_ptr<net::connection> Connection = net::connection::materialize(Entry, *Contexts); Connection != nullptr)
+				{
+					boost::asio::io_context& Context = Connection->get_context();
+
+					boost::asio::post(Context, [Policy, Connection = std::move(Connection)](void) mutable -> void {
+						try
+						{
+							Policy->handler(std::move(Connection));
+						}
+						catch (...)
+						{ }
+					});
+				}
+				break;
+			}
+			send(Entry, Policy->message);
+			break;
+		default:
+			// `backlog` gets here only if several acceptors have overfilled the order at once
+			reset(Entry);
+			break;
+	}
+}
+
+void net::rejector::reset(net::entry const& Entry)
+{
+	const linger Linger = { 1, 0 };
+
+	::setsockopt(Entry.descriptor, SOL_SOCKET, SO_LINGER, &Linger, sizeof(Linger));
+	::close(Entry.descriptor);
+	net::buffer::recycle(Entry.prefetched);
+}
+
+void net::rejector::send(net::entry const& Entry, std::string_view Message)
+{
+	::send(Entry.descriptor, Message.data(), Message.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+	::close(Entry.descriptor);
+	net::buffer::recycle(Entry.prefetched);
+}
@@ -0,0 +1,117 @@
+# include <netordering/sharded.hpp>
+
+# include <pthread.h>
+
+net::sharded_server::pinned::pinned(std::vector<std::size_t> const& Cpus) : Restore(false)
+{
+	cpu_set_t Set;
+
+	CPU_ZERO(&Set);
+	for (std::size_t Cpu : Cpus)
+		if (Cpu < CPU_SETSIZE)
+			CPU_SET(Cpu, &Set);
+
+	if (::pthread_getaffinity_np(::pthread_self(), sizeof(Previous), &Previous) == 0)
+		Restore = ::pthread_setaffinity_np(::pthread_self(), sizeof(Set), &Set) == 0;
+}
+
+net::sharded_server::pinned::~pinned(void)
+{
+	if (Restore)
+		::pthread_setaffinity_np(::pthread_self(), sizeof(Previous), &Previous);
+}
+
+net::sharded_server::~sharded_server(void)
+{
+	for (auto& Shard : Shards)
+	{
+		Shard->set_stealing(false);
+		Shard->set_peers({ });
+	}
+}
+
+std::size_t net::sharded_server::size(void) const
+{
+	return Shards.size();
+}
+
+net::server& net::sharded_server::shard(const std::size_t Index)
+{
+	return *Shards.at(Index);
+}
+
+std::vector<std::size_t> const& net::sharded_server::cpus(const std::size_t Index) const
+{
+	return Cpus.at(Index);
+}
+
+void net::sharded_server::set_stealing(const bool Stealing)
+{
+	for (auto& Shard : Shards)
+		Shard->set_stealing(Stealing);
+}
+
+void net::sharded_server::set_backend(const net::backend Kind)
+{
+	for (auto& Shard : Shards)
+		Shard->set_backend(Kind);
+}
+
+bool net::sharded_server::drain(const std::chrono::steady_clock::time_point Deadline)
+{
+	bool Result = true;
+
+	for (auto& Shard : Shards)
+		Shard->disable();
+	for (auto& Shard : Shards)
+		Result &= Shard->drain(Deadline);
+	return Result;
+}
+
+std::vector<std::size_t> net::sharded_server::listeners(void)
+{
+	return Shards.front()->listeners();
+}
+
+net::metrics net::sharded_server::snapshot(void)
+{
+	net::metrics Result;
+
+	for (auto& Shard : Shards)
+		net::merge(Result, Shard->snapshot());
+	return Result;
+}
+
+void net::sharded_server::plan(topology Topology)
+{
+	if (Topology.cpus.empty())
+	{
+		cpu_set_t Set;
+
+		if (::sched_getaffinity(0, sizeof(Set), &Set) == 0)
+			for (std::size_t Cpu = 0; Cpu < CPU_SETSIZE; Cpu += 1)
+				if (CPU_ISSET(Cpu, &Set))
+					Topology.cpus.push_back(Cpu);
+		if (Topology.cpus.empty())
+			Topology.cpus.push_back(0);
+	}
+
+	const std::size_t Count = Topology.shards == 0 ? Topology.cpus.size() : Topology.shards;
+
+	// Shards get equal slices of CPUs, or share them round-robin if there are more shards than CPUs
+	Cpus.resize(Count);
+	for (std::size_t Index = 0; Index < Count; Index += 1)
+		if (Count >= Topology.cpus.size())
+			Cpus[Index].push_back(Topology.cpus[Index % Topology.cpus.size()]);
+		else
+			for (std::size_t Cpu = Index * Topology.cpus.size() / Count; Cpu < (Index + 1) * Topology.cpus.size() / Count; Cpu += 1)
+				Cpus[Index].push_back(Topology.cpus[Cpu]);
+}
+
+void net::sharded_server::connect(void)
+{
+	std::vector<std::weak_ptr<net::server>> Peers(Shards.begin(), Shards.end());
+
+	for (auto& Shard : Shards)
+		Shard->set_peers(Peers);
+}
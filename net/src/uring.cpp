@@ -0,0 +1,217 @@
+# include <netordering/uring.hpp>
+
+# ifdef NETORDERING_IO_URING
+
+# include <system_error>
+# include <algorithm>
+# include <cstring>
+# include <vector>
+
+# include <sys/syscall.h>
+# include <sys/mman.h>
+# include <unistd.h>
+# include <errno.h>
+
+static int uring_setup(const unsigned Entries, io_uring_params* Parameters)
+{
+	return static_cast<int>(::syscall(__NR_io_uring_setup, Entries, Parameters));
+}
+
+static int uring_enter(const int Descriptor, const unsigned Submit, const unsigned Wait, const unsigned Flags)
+{
+	return static_cast<int>(::syscall(__NR_io_uring_enter, Descriptor, Submit, Wait, Flags, nullptr, 0));
+}
+
+static int uring_register(const int Descriptor, const unsigned Opcode, void* Argument, const unsigned Count)
+{
+	return static_cast<int>(::syscall(__NR_io_uring_register, Descriptor, Opcode, Argument, Count));
+}
+
+net::uring::uring(const unsigned Entries) : Descriptor(-1),
+	Sqes(static_cast<io_uring_sqe*>(MAP_FAILED)),
+	SqRing(MAP_FAILED),
+	CqRing(MAP_FAILED),
+	SqRingSize(0),
+	CqRingSize(0),
+	SqesSize(0),
+	Tail(0),
+	Submitted(0),
+	InFlight(0),
+	Buffers(nullptr),
+	BuffersSize(0),
+	BuffersMask(0),
+	BuffersTail(0),
+	BuffersGroup(0)
+{
+	io_uring_params Parameters;
+
+	std::memset(&Parameters, 0, sizeof(Parameters));
+	Descriptor = uring_setup(Entries, &Parameters);
+	if (Descriptor < 0)
+		throw std::system_error(errno, std::system_category(), "io_uring_setup");
+
+	SqRingSize = Parameters.sq_off.array + Parameters.sq_entries * sizeof(unsigned);
+	CqRingSize = Parameters.cq_off.cqes + Parameters.cq_entries * sizeof(io_uring_cqe);
+	SqesSize = Parameters.sq_entries * sizeof(io_uring_sqe);
+
+	// Since 5.4 both rings are in one mapping
+	if (Parameters.features & IORING_FEAT_SINGLE_MMAP)
+		SqRingSize = CqRingSize = std::max(SqRingSize, CqRingSize);
+
+	SqRing = ::mmap(nullptr, SqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, Descriptor, IORING_OFF_SQ_RING);
+	CqRing = Parameters.features & IORING_FEAT_SINGLE_MMAP ? SqRing
+		: ::mmap(nullptr, CqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, Descriptor, IORING_OFF_CQ_RING);
+	Sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, SqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, Descriptor, IORING_OFF_SQES));
+
+	if (SqRing == MAP_FAILED || CqRing == MAP_FAILED || Sqes == MAP_FAILED)
+	{
+		const int Error = errno;
+
+		release();
+		throw std::system_error(Error, std::system_category(), "io_uring mmap");
+	}
+
+	char* Sq = static_cast<char*>(SqRing);
+	char* Cq = static_cast<char*>(CqRing);
+
+	SqHead = reinterpret_cast<unsigned*>(Sq + Parameters.sq_off.head);
+	SqTail = reinterpret_cast<unsigned*>(Sq + Parameters.sq_off.tail);
+	SqMask = *reinterpret_cast<unsigned*>(Sq + Parameters.sq_off.ring_mask);
+	SqEntries = Parameters.sq_entries;
+	SqArray = reinterpret_cast<unsigned*>(Sq + Parameters.sq_off.array);
+	CqHead = reinterpret_cast<unsigned*>(Cq + Parameters.cq_off.head);
+	CqTail = reinterpret_cast<unsigned*>(Cq + Parameters.cq_off.tail);
+	CqMask = *reinterpret_cast<unsigned*>(Cq + Parameters.cq_off.ring_mask);
+	Cqes = reinterpret_cast<io_uring_cqe*>(Cq + Parameters.cq_off.cqes);
+	Tail = *SqTail;
+	Submitted = Tail;
+}
+
+net::uring::~uring(void)
+{
+	release();
+}
+
+void net::uring::release(void)
+{
+	// Closing the ring cancels all requests which are in flight
+	if (Descriptor >= 0)
+		::close(Descriptor);
+	if (Buffers != nullptr)
+		::munmap(Buffers, BuffersSize);
+	if (Sqes != MAP_FAILED)
+		::munmap(Sqes, SqesSize);
+	if (CqRing != MAP_FAILED && CqRing != SqRing)
+		::munmap(CqRing, CqRingSize);
+	if (SqRing != MAP_FAILED)
+		::munmap(SqRing, SqRingSize);
+
+	Descriptor = -1;
+	Buffers = nullptr;
+	Sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+	CqRing = SqRing = MAP_FAILED;
+}
+
+bool net::uring::supported(void)
+{
+	static const bool Result = [](void) -> bool {
+		try
+		{
+			net::uring Ring(2);
+			const std::size_t Size = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+			std::vector<unsigned char> Memory(Size, 0);
+			io_uring_probe* Probe = reinterpret_cast<io_uring_probe*>(Memory.data());
+
+			if (uring_register(Ring.Descriptor, IORING_REGISTER_PROBE, Probe, 256) < 0)
+				return false;
+
+			for (const unsigned Opcode : { IORING_OP_ACCEPT, IORING_OP_READ, IORING_OP_RECV, IORING_OP_SENDMSG, IORING_OP_ASYNC_CANCEL })
+				if (Opcode > Probe->last_op || !(Probe->ops[Opcode].flags & IO_URING_OP_SUPPORTED))
+					return false;
+			return true;
+		}
+		catch (std::system_error const&)
+		{
+			return false;
+		}
+	}();
+
+	return Result;
+}
+
+io_uring_sqe* net::uring::sqe(void)
+{
+	if (Tail - std::atomic_ref<unsigned>(*SqHead).load(std::memory_order_acquire) >= SqEntries)
+		return nullptr;
+
+	const unsigned Index = Tail & SqMask;
+	io_uring_sqe* Result = &Sqes[Index];
+
+	std::memset(Result, 0, sizeof(io_uring_sqe));
+	SqArray[Index] = Index;
+	Tail += 1;
+
+	return Result;
+}
+
+int net::uring::submit(const unsigned Wait)
+{
+	std::atomic_ref<unsigned>(*SqTail).store(Tail, std::memory_order_release);
+
+	while (true)
+	{
+		const int Result = uring_enter(Descriptor, Tail - Submitted, Wait, Wait != 0 ? IORING_ENTER_GETEVENTS : 0);
+
+		if (Result >= 0)
+		{
+			Submitted += static_cast<unsigned>(Result);
+			InFlight += static_cast<unsigned>(Result);
+			return Result;
+		}
+		if (errno != EINTR)
+			return -errno;
+	}
+}
+
+bool net::uring::provide(const std::uint16_t Group, const unsigned Entries)
+{
+	BuffersSize = Entries * sizeof(io_uring_buf);
+
+	void* Memory = ::mmap(nullptr, BuffersSize, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+
+	if (Memory == MAP_FAILED)
+		return false;
+
+	io_uring_buf_reg Registration;
+
+	std::memset(&Registration, 0, sizeof(Registration));
+	Registration.ring_addr = reinterpret_cast<std::uint64_t>(Memory);
+	Registration.ring_entries = Entries;
+	Registration.bgid = Group;
+
+	if (uring_register(Descriptor, IORING_REGISTER_PBUF_RING, &Registration, 1) < 0)
+	{
+		::munmap(Memory, BuffersSize);
+		return false;
+	}
+
+	Buffers = static_cast<io_uring_buf_ring*>(Memory);
+	BuffersMask = Entries - 1;
+	BuffersTail = 0;
+	BuffersGroup = Group;
+	return true;
+}
+
+void net::uring::recycle(void* Address, const unsigned Length, const std::uint16_t Id)
+{
+	io_uring_buf& Buffer = Buffers->bufs[BuffersTail & BuffersMask];
+
+	Buffer.addr = reinterpret_cast<std::uint64_t>(Address);
+	Buffer.len = Length;
+	Buffer.bid = Id;
+	BuffersTail += 1;
+
+	std::atomic_ref<std::uint16_t>(Buffers->tail).store(BuffersTail, std::memory_order_release);
+}
+
+# endif
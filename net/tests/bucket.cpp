@@ -0,0 +1,118 @@
+# include <gtest/gtest.h>
+
+# include <netordering/bucket.hpp>
+
+# include <thread>
+# include <vector>
+# include <atomic>
+
+static constexpr std::int64_t Millisecond = 1000000;
+static constexpr std::int64_t Second = 1000 * Millisecond;
+static constexpr std::int64_t Start = 1000 * Second;
+
+TEST(bucket, disabled_takes_everything)
+{
+	net::token_bucket Bucket;
+
+	EXPECT_FALSE(Bucket.limited());
+	EXPECT_EQ(Bucket.take(1000000, Start), 1000000);
+	EXPECT_EQ(Bucket.get_rate(), 0);
+
+	Bucket.set(100, 10);
+	Bucket.set(0, 10);
+	EXPECT_FALSE(Bucket.limited());
+	EXPECT_EQ(Bucket.take(1000, Start), 1000);
+}
+
+TEST(bucket, settings_are_read_back)
+{
+	net::token_bucket Bucket;
+
+	Bucket.set(1000, 10);
+	EXPECT_TRUE(Bucket.limited());
+	EXPECT_EQ(Bucket.get_rate(), 1000);
+	EXPECT_EQ(Bucket.get_burst(), 10);
+
+	// Burst 0 is one second of rate
+	Bucket.set(50, 0);
+	EXPECT_EQ(Bucket.get_burst(), 50);
+}
+
+TEST(bucket, burst_then_rate)
+{
+	net::token_bucket Bucket;
+
+	Bucket.set(1000, 10);
+	EXPECT_EQ(Bucket.take(50, Start), 10);
+	EXPECT_EQ(Bucket.take(5, Start), 0);
+
+	// One token per millisecond comes back
+	EXPECT_EQ(Bucket.take(50, Start + 5 * Millisecond), 5);
+	EXPECT_EQ(Bucket.take(1, Start + 5 * Millisecond), 0);
+	EXPECT_EQ(Bucket.take(1, Start + 6 * Millisecond), 1);
+}
+
+TEST(bucket, idle_bucket_saves_only_burst)
+{
+	net::token_bucket Bucket;
+
+	Bucket.set(1000, 10);
+	EXPECT_EQ(Bucket.take(50, Start), 10);
+	EXPECT_EQ(Bucket.take(50, Start + Second), 10);
+	EXPECT_EQ(Bucket.take(50, Start + 100 * Second), 10);
+}
+
+TEST(bucket, refund_gives_tokens_back)
+{
+	net::token_bucket Bucket;
+
+	Bucket.set(1000, 10);
+	ASSERT_EQ(Bucket.take(10, Start), 10);
+	Bucket.refund(3);
+	EXPECT_EQ(Bucket.take(50, Start), 3);
+	EXPECT_EQ(Bucket.take(50, Start), 0);
+}
+
+TEST(bucket, set_keeps_taken_tokens)
+{
+	net::token_bucket Bucket;
+
+	Bucket.set(1000, 10, Start);
+	ASSERT_EQ(Bucket.take(10, Start), 10);
+	Bucket.set(1000, 20, Start);
+	EXPECT_EQ(Bucket.take(50, Start), 10);
+	EXPECT_EQ(Bucket.take(50, Start), 0);
+}
+
+TEST(bucket, smaller_burst_limits_debt)
+{
+	net::token_bucket Bucket;
+
+	Bucket.set(1000, 100, Start);
+	ASSERT_EQ(Bucket.take(100, Start), 100);
+	Bucket.set(1000, 10, Start);
+	EXPECT_EQ(Bucket.take(50, Start), 0);
+
+	// Empty bucket of the new burst refills by the rate, not after 100 tokens of the old one
+	EXPECT_EQ(Bucket.take(50, Start + 5 * Millisecond), 5);
+	EXPECT_EQ(Bucket.get_burst(), 10);
+}
+
+TEST(bucket, concurrent_takers_do_not_exceed_burst)
+{
+	static constexpr std::size_t Threads = 4;
+	net::token_bucket Bucket;
+	std::atomic<std::size_t> Taken = 0;
+	std::vector<std::thread> Takers;
+
+	Bucket.set(1, 1000);
+	for (std::size_t Index = 0; Index < Threads; Index += 1)
+		Takers.emplace_back([&](void) -> void {
+			for (std::size_t Attempt = 0; Attempt < 1000; Attempt += 1)
+				Taken.fetch_add(Bucket.take(1, Start), std::memory_order_relaxed);
+		});
+	for (std::thread& Taker : Takers)
+		Taker.join();
+
+	EXPECT_EQ(Taken.load(), 1000);
+}
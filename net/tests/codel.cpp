@@ -0,0 +1,79 @@
+# include <gtest/gtest.h>
+
+# include <netordering/codel.hpp>
+
+static constexpr std::int64_t Millisecond = 1000000;
+static constexpr std::int64_t Target = 5 * Millisecond;
+static constexpr std::int64_t Interval = 100 * Millisecond;
+
+TEST(codel, disabled_never_drops)
+{
+	net::codel Codel;
+
+	EXPECT_EQ(Codel.get_target(), 0);
+	for (std::int64_t Now = 1; Now < 10 * Interval; Now += Millisecond)
+		ASSERT_FALSE(Codel.drop(Interval, Now, false));
+}
+
+TEST(codel, short_sojourn_is_not_dropped)
+{
+	net::codel Codel;
+
+	Codel.set(Target, Interval);
+	for (std::int64_t Now = 1; Now < 10 * Interval; Now += Millisecond)
+		ASSERT_FALSE(Codel.drop(Target - 1, Now, false));
+}
+
+TEST(codel, drops_after_interval_above_target)
+{
+	net::codel Codel;
+	std::int64_t Now = Millisecond;
+
+	Codel.set(Target, Interval);
+	EXPECT_FALSE(Codel.drop(2 * Target, Now, false));
+	EXPECT_FALSE(Codel.drop(2 * Target, Now + Interval - 1, false));
+	EXPECT_TRUE(Codel.drop(2 * Target, Now + Interval, false));
+	// The next drop is Interval later, the one after it Interval / sqrt(2)
+	Now += Interval;
+	EXPECT_FALSE(Codel.drop(2 * Target, Now + 1, false));
+	EXPECT_FALSE(Codel.drop(2 * Target, Now + Interval - 1, false));
+	EXPECT_TRUE(Codel.drop(2 * Target, Now + Interval, false));
+	Now += Interval;
+	EXPECT_FALSE(Codel.drop(2 * Target, Now + 70 * Millisecond, false));
+	EXPECT_TRUE(Codel.drop(2 * Target, Now + 71 * Millisecond, false));
+}
+
+TEST(codel, drops_get_closer_while_overloaded)
+{
+	net::codel Codel;
+	std::int64_t Previous = 0;
+	std::int64_t PreviousGap = Interval + 1;
+	std::size_t Drops = 0;
+
+	Codel.set(Target, Interval);
+	for (std::int64_t Now = Millisecond; Now < 20 * Interval; Now += Millisecond / 10)
+		if (Codel.drop(2 * Target, Now, false))
+		{
+			if (Previous != 0)
+			{
+				ASSERT_LE(Now - Previous, PreviousGap);
+				PreviousGap = Now - Previous;
+			}
+			Previous = Now;
+			Drops += 1;
+		}
+	EXPECT_GT(Drops, 20u);
+}
+
+TEST(codel, empty_order_stops_dropping)
+{
+	net::codel Codel;
+	std::int64_t Now = Millisecond;
+
+	Codel.set(Target, Interval);
+	Codel.drop(2 * Target, Now, false);
+	EXPECT_TRUE(Codel.drop(2 * Target, Now + Interval, false));
+	// One slow client which leaves the order empty is not an overload
+	EXPECT_FALSE(Codel.drop(2 * Target, Now + 3 * Interval, true));
+	EXPECT_FALSE(Codel.drop(2 * Target, Now + 3 * Interval + 1, false));
+}
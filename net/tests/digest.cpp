@@ -0,0 +1,111 @@
+# include <gtest/gtest.h>
+
+# include <netordering/digest.hpp>
+
+# include <string>
+# include <vector>
+
+static std::string reference_hex(std::span<const unsigned char> Bytes)
+{
+	static constexpr char Digits[] = "0123456789abcdef";
+	std::string Result;
+
+	for (const unsigned char Byte : Bytes)
+	{
+		Result.push_back(Digits[Byte >> 4]);
+		Result.push_back(Digits[Byte & 0x0f]);
+	}
+	return Result;
+}
+
+TEST(digest, hex_matches_reference_for_every_length)
+{
+	std::vector<unsigned char> Bytes(70);
+
+	for (std::size_t Index = 0; Index < Bytes.size(); Index += 1)
+		Bytes[Index] = static_cast<unsigned char>(Index * 37 + 11);
+
+	// Lengths around 16 cover the vector loop, the tail after it and both together
+	for (std::size_t Size = 0; Size <= Bytes.size(); Size += 1)
+	{
+		const std::span<const unsigned char> Span(Bytes.data(), Size);
+		std::string Out(2 * Size + 1, '#');
+
+		ASSERT_EQ(net::hex(Span, Out.data()), 2 * Size) << Size;
+		EXPECT_EQ(Out.substr(0, 2 * Size), reference_hex(Span)) << Size;
+		EXPECT_EQ(Out.back(), '#') << Size;
+	}
+}
+
+TEST(digest, hex_covers_every_byte_value)
+{
+	std::vector<unsigned char> Bytes(256);
+	std::string Out(512, '\0');
+
+	for (std::size_t Index = 0; Index < Bytes.size(); Index += 1)
+		Bytes[Index] = static_cast<unsigned char>(Index);
+	ASSERT_EQ(net::hex(Bytes, Out.data()), Out.size());
+	EXPECT_EQ(Out, reference_hex(Bytes));
+}
+
+TEST(digest, known_vectors)
+{
+	EXPECT_EQ(net::hash(net::algorithm::md5, "").hex(), "d41d8cd98f00b204e9800998ecf8427e");
+	EXPECT_EQ(net::hash(net::algorithm::sha1, "abc").hex(), "a9993e364706816aba3e25717850c26c9cd0d89d");
+	EXPECT_EQ(net::hash(net::algorithm::sha256, "abc").hex(), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+	EXPECT_EQ(net::hash(net::algorithm::sha512, "abc").size, 64);
+}
+
+TEST(digest, streaming_and_batch_equal_one_shot)
+{
+	const std::string Data = "The quick brown fox jumps over the lazy dog";
+	net::hasher Hasher(net::algorithm::sha256);
+
+	Hasher.update(std::string_view(Data).substr(0, 10)).update({ std::string_view(Data).substr(10, 5), std::string_view(Data).substr(15) });
+	EXPECT_EQ(Hasher.finish(), net::hash(net::algorithm::sha256, Data));
+
+	// finish() starts a new digest
+	Hasher.update("abc");
+	EXPECT_EQ(Hasher.finish(), net::hash(net::algorithm::sha256, "abc"));
+
+	const std::vector<std::string_view> Payloads = { "", "a", Data };
+	std::vector<net::digest> Results(Payloads.size());
+
+	net::hash(net::algorithm::md5, Payloads, Results);
+	for (std::size_t Index = 0; Index < Payloads.size(); Index += 1)
+		EXPECT_EQ(Results[Index], net::hash(net::algorithm::md5, Payloads[Index]));
+}
+
+TEST(digest, etag_and_if_none_match)
+{
+	const net::digest Digest = net::hash(net::algorithm::md5, "");
+	const std::string Tag = Digest.etag();
+
+	EXPECT_EQ(Tag, "\"d41d8cd98f00b204e9800998ecf8427e\"");
+	EXPECT_TRUE(Digest.matches(Tag));
+	EXPECT_TRUE(Digest.matches("W/" + Tag));
+	EXPECT_TRUE(Digest.matches("\"other\", \t" + Tag + " "));
+	EXPECT_TRUE(Digest.matches("*"));
+	EXPECT_FALSE(Digest.matches(""));
+	EXPECT_FALSE(Digest.matches(Digest.hex()));
+	EXPECT_FALSE(Digest.matches("\"d41d8cd98f00b204e9800998ecf8427\""));
+}
+
+TEST(digest, response_cache_evicts_least_recently_used)
+{
+	net::response_cache Cache(2);
+	const net::digest First = net::hash(net::algorithm::sha1, "1");
+	const net::digest Second = net::hash(net::algorithm::sha1, "2");
+	const net::digest Third = net::hash(net::algorithm::sha1, "3");
+
+	Cache.insert(First, "first");
+	Cache.insert(Second, "second");
+	ASSERT_NE(Cache.find(First), nullptr);
+	Cache.insert(Third, "third");
+
+	EXPECT_EQ(Cache.size(), 2);
+	EXPECT_EQ(Cache.find(Second), nullptr);
+	EXPECT_EQ(*Cache.find(First), "first");
+	EXPECT_EQ(*Cache.get(Third, [](void) -> std::string { return "rendered"; }), "third");
+	EXPECT_EQ(*Cache.get(Second, [](void) -> std::string { return "rendered"; }), "rendered");
+}
@@ -0,0 +1,203 @@
+# include <gtest/gtest.h>
+
+# include <netordering/net.hpp>
+
+# include <vector>
+
+/*
+*	Buckets are chosen by a random salt, with this many of them a few sources share one very rarely
+*/
+static constexpr std::size_t Buckets = 65536;
+
+/*
+*	Client without a socket, so the order may close it
+*/
+static net::entry client(const std::uint8_t Source, const std::uint16_t Port = 1)
+{
+	net::entry Result;
+
+	Result.family = 4;
+	Result.peer_address = { 10, 0, 0, Source };
+	Result.peer_port = Port;
+	return Result;
+}
+
+static net::entry client6(std::array<std::uint8_t, 16> const& Address)
+{
+	net::entry Result;
+
+	Result.family = 6;
+	Result.peer_address = Address;
+	Result.peer_port = 1;
+	return Result;
+}
+
+static std::size_t push(net::fair_queue& Fair, net::entry const& Entry, const std::size_t Limit = 0)
+{
+	std::vector<net::entry> Batch = { Entry };
+
+	return Fair.push(Batch, Limit);
+}
+
+TEST(fair, disabled_order_is_one_fifo)
+{
+	net::fair_queue Fair;
+	std::vector<net::entry> Batch = { client(1, 1), client(2, 2), client(1, 3) };
+	net::fair_queue::ticket Ticket;
+
+	EXPECT_FALSE(Fair.enabled());
+	EXPECT_EQ(Fair.buckets(), 0);
+	ASSERT_EQ(Fair.push(Batch, 0), 3);
+	for (const std::uint16_t Port : { 1, 2, 3 })
+		EXPECT_EQ(Fair.pop(Ticket)->peer_port, Port);
+	EXPECT_FALSE(Fair.pop(Ticket).has_value());
+}
+
+TEST(fair, sources_take_turns)
+{
+	net::fair_queue Fair;
+	std::vector<net::entry> Batch = { client(1, 1), client(1, 2), client(1, 3), client(2, 1), client(2, 2) };
+	net::fair_queue::ticket Ticket;
+
+	Fair.configure(Buckets, 0);
+	EXPECT_TRUE(Fair.enabled());
+	ASSERT_EQ(Fair.push(Batch, 0), 5);
+	EXPECT_EQ(Fair.size(), 5);
+
+	// Every source keeps its own order, sources alternate while both have clients
+	const std::vector<std::pair<std::uint8_t, std::uint16_t>> Expected = { { 1, 1 }, { 2, 1 }, { 1, 2 }, { 2, 2 }, { 1, 3 } };
+
+	for (auto const& [Source, Port] : Expected)
+	{
+		const std::optional<net::entry> Entry = Fair.pop(Ticket);
+
+		ASSERT_TRUE(Entry.has_value());
+		EXPECT_EQ(Entry->peer_address[3], Source);
+		EXPECT_EQ(Entry->peer_port, Port);
+	}
+	EXPECT_EQ(Fair.size(), 0);
+}
+
+TEST(fair, cap_counts_queued_and_popped_clients)
+{
+	net::fair_queue Fair;
+	std::vector<net::entry> Batch = { client(1, 1), client(1, 2), client(1, 3), client(2, 1) };
+	net::fair_queue::ticket Ticket;
+
+	Fair.configure(Buckets, 2);
+	ASSERT_EQ(Fair.push(Batch, 0), 3);
+	// Rejected clients follow the queued ones
+	EXPECT_EQ(Batch.size(), 4);
+	EXPECT_EQ(Batch[3].peer_address[3], 1);
+	EXPECT_EQ(Batch[3].peer_port, 3);
+
+	// Popped client is still counted until its ticket is released
+	ASSERT_EQ(Fair.pop(Ticket)->peer_address[3], 1);
+	EXPECT_EQ(push(Fair, client(1)), 0);
+	Fair.release(Ticket);
+	EXPECT_EQ(push(Fair, client(1)), 1);
+}
+
+TEST(fair, tickets_of_previous_configuration_are_ignored)
+{
+	net::fair_queue Fair;
+	net::fair_queue::ticket Ticket;
+
+	Fair.configure(Buckets, 1);
+	ASSERT_EQ(push(Fair, client(1)), 1);
+	ASSERT_TRUE(Fair.pop(Ticket).has_value());
+
+	Fair.configure(Buckets, 1);
+	ASSERT_EQ(push(Fair, client(1)), 1);
+	Fair.release(Ticket);
+	EXPECT_EQ(push(Fair, client(1)), 0);
+
+	// Default ticket is not of any bucket
+	Fair.release(net::fair_queue::ticket());
+	EXPECT_EQ(push(Fair, client(1)), 0);
+}
+
+TEST(fair, full_order_pushes_out_the_longest_source)
+{
+	net::fair_queue Fair;
+	std::vector<net::entry> Batch = { client(1, 1), client(1, 2), client(1, 3), client(1, 4) };
+
+	Fair.configure(Buckets, 0);
+	ASSERT_EQ(Fair.push(Batch, 4), 4);
+
+	// The oldest client of the longest source gives its place
+	Batch = { client(2) };
+	ASSERT_EQ(Fair.push(Batch, 4), 1);
+	ASSERT_EQ(Batch.size(), 2);
+	EXPECT_EQ(Batch[1].peer_address[3], 1);
+	EXPECT_EQ(Batch[1].peer_port, 1);
+	EXPECT_EQ(Fair.size(), 4);
+
+	// Client of the longest source itself is rejected
+	Batch = { client(1, 5) };
+	EXPECT_EQ(Fair.push(Batch, 4), 0);
+	EXPECT_EQ(Fair.size(), 4);
+
+	// Shorter sources push out the longest one while it would stay longer than theirs
+	Batch = { client(2), client(3) };
+	EXPECT_EQ(Fair.push(Batch, 4), 2);
+	Batch = { client(3) };
+	EXPECT_EQ(Fair.push(Batch, 4), 0);
+}
+
+TEST(fair, disabling_keeps_queued_clients)
+{
+	net::fair_queue Fair;
+	std::vector<net::entry> Batch = { client(1), client(2), client(3) };
+	net::fair_queue::ticket Ticket;
+
+	Fair.configure(Buckets, 0);
+	ASSERT_EQ(Fair.push(Batch, 0), 3);
+	Fair.configure(0, 0);
+	EXPECT_FALSE(Fair.enabled());
+	EXPECT_EQ(Fair.size(), 3);
+	for (std::size_t Index = 0; Index < 3; Index += 1)
+		ASSERT_TRUE(Fair.pop(Ticket).has_value());
+	EXPECT_FALSE(Fair.pop(Ticket).has_value());
+}
+
+TEST(fair, ipv6_source_is_its_64_prefix)
+{
+	net::fair_queue Fair;
+
+	Fair.configure(Buckets, 1);
+	ASSERT_EQ(push(Fair, client6({ 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1 })), 1);
+	EXPECT_EQ(push(Fair, client6({ 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 1, 0xff, 0, 0, 0, 0, 0, 0, 2 })), 0);
+	EXPECT_EQ(push(Fair, client6({ 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 1 })), 1);
+}
+
+TEST(fair, ipv4_mapped_source_is_its_ipv4_address)
+{
+	net::fair_queue Fair;
+
+	Fair.configure(Buckets, 1);
+	ASSERT_EQ(push(Fair, client6({ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff, 10, 0, 0, 1 })), 1);
+	EXPECT_EQ(push(Fair, client6({ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff, 10, 0, 0, 2 })), 1);
+	// Same client over IPv4 and IPv4-mapped IPv6 is one source
+	EXPECT_EQ(push(Fair, client(1)), 0);
+}
+
+TEST(fair, nodes_are_reused)
+{
+	net::fair_queue Fair;
+	net::fair_queue::ticket Ticket;
+
+	Fair.configure(Buckets, 0);
+	for (std::size_t Round = 0; Round < 1000; Round += 1)
+	{
+		std::vector<net::entry> Batch = { client(1), client(2), client(3) };
+
+		ASSERT_EQ(Fair.push(Batch, 0), 3);
+		for (std::size_t Index = 0; Index < 3; Index += 1)
+		{
+			ASSERT_TRUE(Fair.pop(Ticket).has_value());
+			Fair.release(Ticket);
+		}
+		ASSERT_EQ(Fair.size(), 0);
+	}
+}
@@ -0,0 +1,79 @@
+# include <gtest/gtest.h>
+
+# include <netordering/metrics.hpp>
+
+# include <initializer_list>
+# include <limits>
+
+TEST(histogram, buckets_cover_their_values)
+{
+	// Every value falls into the bucket whose upper bound is not below it, and not into the previous one
+	for (const std::uint64_t Value : std::initializer_list<std::uint64_t>{ 0, 1, 7, 8, 9, 15, 16, 1000, 123456789, std::numeric_limits<std::uint64_t>::max() })
+	{
+		const std::size_t Index = net::histogram::index(Value);
+
+		ASSERT_LT(Index, net::histogram::Buckets);
+		EXPECT_GE(net::histogram::upper(Index), Value);
+		if (Index != 0)
+		{
+			EXPECT_LT(net::histogram::upper(Index - 1), Value);
+		}
+	}
+}
+
+TEST(histogram, relative_error_is_bounded)
+{
+	for (std::uint64_t Value = 8; Value < (std::uint64_t(1) << 40); Value = Value * 3 + 1)
+	{
+		const std::uint64_t Upper = net::histogram::upper(net::histogram::index(Value));
+
+		EXPECT_LE(static_cast<double>(Upper - Value), static_cast<double>(Value) * 0.125);
+	}
+}
+
+TEST(histogram, empty_percentile_is_zero)
+{
+	net::histogram Histogram;
+
+	EXPECT_EQ(Histogram.snapshot().percentile(0.5), 0u);
+}
+
+TEST(histogram, percentiles_of_uniform_values)
+{
+	net::histogram Histogram;
+
+	for (std::uint64_t Value = 1; Value <= 1000; Value += 1)
+		Histogram.record(Value * 1000);
+
+	const net::histogram_snapshot Snapshot = Histogram.snapshot();
+
+	EXPECT_EQ(Snapshot.count, 1000u);
+	EXPECT_EQ(Snapshot.max, 1000000u);
+	EXPECT_EQ(Snapshot.sum, 500500000u);
+
+	// Bucket bound is at most 12.5% above the exact value
+	EXPECT_GE(Snapshot.percentile(0.5), 500000u);
+	EXPECT_LE(Snapshot.percentile(0.5), 562500u);
+	EXPECT_GE(Snapshot.percentile(0.99), 990000u);
+	EXPECT_LE(Snapshot.percentile(0.99), 1000000u);
+	// The last bucket is capped by the maximum
+	EXPECT_EQ(Snapshot.percentile(1.0), 1000000u);
+	EXPECT_LE(Snapshot.percentile(0.0), 1125u);
+}
+
+TEST(histogram, percentile_of_single_outlier)
+{
+	net::histogram Histogram;
+
+	for (std::size_t Index = 0; Index < 999; Index += 1)
+		Histogram.record(10);
+	Histogram.record(1000000);
+
+	const net::histogram_snapshot Snapshot = Histogram.snapshot();
+
+	// Values below 16 have buckets of their own
+	EXPECT_EQ(Snapshot.percentile(0.99), 10u);
+	EXPECT_EQ(Snapshot.percentile(0.9999), 1000000u);
+	EXPECT_EQ(Snapshot.below(10), 0u);
+	EXPECT_EQ(Snapshot.below(11), 999u);
+}
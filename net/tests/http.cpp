@@ -0,0 +1,242 @@
+# include <gtest/gtest.h>
+
+# include <netordering/net.hpp>
+
+# include <limits>
+# include <string>
+
+/*
+*	Every test runs with every scanner which CPU has, values are longer than 32 bytes so SIMD loops are used
+*/
+class scanned : public ::testing::TestWithParam<net::scan>
+{
+	net::scan Previous = net::get_scan();
+
+	protected:
+		void SetUp(void) override
+		{
+			if (!net::set_scan(GetParam()))
+				GTEST_SKIP() << "CPU does not have this scanner";
+		}
+
+		void TearDown(void) override
+		{
+			net::set_scan(Previous);
+		}
+};
+
+static const std::string Long = std::string(70, 'v');
+
+TEST_P(scanned, parses_request_line_and_headers)
+{
+	const std::string Data = "POST /path?query=" + Long + " HTTP/1.1\r\nHost: example.com\r\nX-Long: \t" + Long + " \t\r\nContent-Length: 4\r\n\r\nbody";
+	net::request_view Request;
+
+	ASSERT_EQ(net::parse(Data, Request), net::framing::complete);
+	EXPECT_EQ(Request.method, "POST");
+	EXPECT_EQ(Request.target, "/path?query=" + Long);
+	EXPECT_EQ(Request.minor_version, 1);
+	EXPECT_EQ(Request.header_count, 3);
+	EXPECT_EQ(Request.header("host"), "example.com");
+	EXPECT_EQ(Request.header("X-LONG"), Long);
+	EXPECT_EQ(Request.header("Missing"), "");
+	EXPECT_EQ(Request.body, "body");
+	EXPECT_TRUE(Request.keep_alive);
+	EXPECT_EQ(Request.size, Data.size());
+}
+
+TEST_P(scanned, every_prefix_is_partial)
+{
+	const std::string Data = "GET /" + Long + " HTTP/1.1\r\nHost: example.com\r\nX-Long: " + Long + "\r\nContent-Length: 3\r\n\r\nabc";
+	net::request_view Request;
+
+	for (std::size_t Size = 0; Size < Data.size(); Size += 1)
+		ASSERT_EQ(net::parse(std::string_view(Data).substr(0, Size), Request), net::framing::partial) << Size;
+	EXPECT_EQ(net::parse(Data, Request), net::framing::complete);
+}
+
+TEST_P(scanned, partial_body_tells_size)
+{
+	const std::string Head = "PUT / HTTP/1.1\r\nContent-Length: 100000\r\n\r\n";
+	net::request_view Request;
+
+	ASSERT_EQ(net::parse(Head.substr(0, Head.size() - 1), Request), net::framing::partial);
+	EXPECT_EQ(Request.size, 0);
+	ASSERT_EQ(net::parse(Head + "abc", Request), net::framing::partial);
+	EXPECT_EQ(Request.size, Head.size() + 100000);
+}
+
+TEST_P(scanned, pipelined_requests_are_parsed_one_by_one)
+{
+	const std::string First = "GET /first HTTP/1.1\r\nX-Long: " + Long + "\r\n\r\n";
+	const std::string Second = "POST /second HTTP/1.1\r\nContent-Length: 2\r\n\r\nok";
+	const std::string Data = First + Second + "GET /third";
+	net::request_view Request;
+
+	ASSERT_EQ(net::parse(Data, Request), net::framing::complete);
+	EXPECT_EQ(Request.target, "/first");
+	ASSERT_EQ(Request.size, First.size());
+
+	ASSERT_EQ(net::parse(std::string_view(Data).substr(First.size()), Request), net::framing::complete);
+	EXPECT_EQ(Request.target, "/second");
+	EXPECT_EQ(Request.body, "ok");
+	ASSERT_EQ(Request.size, Second.size());
+
+	EXPECT_EQ(net::parse(std::string_view(Data).substr(First.size() + Second.size()), Request), net::framing::partial);
+}
+
+TEST_P(scanned, same_content_length_twice_is_accepted)
+{
+	net::request_view Request;
+
+	ASSERT_EQ(net::parse("POST / HTTP/1.1\r\nContent-Length: 2\r\nContent-Length: 2\r\n\r\nok", Request), net::framing::complete);
+	EXPECT_EQ(Request.body, "ok");
+}
+
+TEST_P(scanned, conflicting_content_length_is_invalid)
+{
+	net::request_view Request;
+
+	EXPECT_EQ(net::parse("POST / HTTP/1.1\r\nContent-Length: 2\r\nContent-Length: 3\r\n\r\nokk", Request), net::framing::invalid);
+	EXPECT_EQ(net::parse("POST / HTTP/1.1\r\nContent-Length: 0\r\nContent-Length: 5\r\n\r\nhello", Request), net::framing::invalid);
+	EXPECT_EQ(net::parse("POST / HTTP/1.1\r\nContent-Length: 5\r\nContent-Length: 0\r\n\r\nhello", Request), net::framing::invalid);
+}
+
+TEST_P(scanned, malformed_content_length_is_invalid)
+{
+	const std::string Oversized = std::to_string(std::numeric_limits<std::size_t>::max()) + "0";
+	net::request_view Request;
+
+	EXPECT_EQ(net::parse("POST / HTTP/1.1\r\nContent-Length: " + Oversized + "\r\n\r\n", Request), net::framing::invalid);
+	EXPECT_EQ(net::parse("POST / HTTP/1.1\r\nContent-Length: -1\r\n\r\n", Request), net::framing::invalid);
+	EXPECT_EQ(net::parse("POST / HTTP/1.1\r\nContent-Length: 1 2\r\n\r\n", Request), net::framing::invalid);
+	EXPECT_EQ(net::parse("POST / HTTP/1.1\r\nContent-Length:\r\n\r\n", Request), net::framing::invalid);
+}
+
+TEST_P(scanned, huge_content_length_waits_for_body)
+{
+	const std::string Huge = std::to_string(std::numeric_limits<std::size_t>::max() / 10);
+	net::request_view Request;
+
+	ASSERT_EQ(net::parse("POST / HTTP/1.1\r\nContent-Length: " + Huge + "\r\n\r\n", Request), net::framing::partial);
+	EXPECT_GT(Request.size, std::numeric_limits<std::size_t>::max() / 10);
+}
+
+TEST_P(scanned, transfer_encoding_is_unsupported)
+{
+	net::request_view Request;
+
+	EXPECT_EQ(net::parse("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n0\r\n\r\n", Request), net::framing::unsupported);
+	EXPECT_EQ(net::parse("POST / HTTP/1.1\r\ntransfer-encoding: gzip\r\nContent-Length: 1\r\n\r\nx", Request), net::framing::unsupported);
+}
+
+TEST_P(scanned, bare_line_feed_ends_lines)
+{
+	const std::string Data = "\nGET / HTTP/1.1\nHost: example.com\nX-Long: " + Long + "\n\n";
+	net::request_view Request;
+
+	ASSERT_EQ(net::parse(Data, Request), net::framing::complete);
+	EXPECT_EQ(Request.header("Host"), "example.com");
+	EXPECT_EQ(Request.header("X-Long"), Long);
+	EXPECT_EQ(Request.size, Data.size());
+}
+
+TEST_P(scanned, carriage_return_without_line_feed_is_invalid)
+{
+	net::request_view Request;
+
+	EXPECT_EQ(net::parse("GET / HTTP/1.1\rHost: example.com\r\n\r\n", Request), net::framing::invalid);
+	EXPECT_EQ(net::parse("GET / HTTP/1.1\r\nHost: example.com\rX: y\r\n\r\n", Request), net::framing::invalid);
+}
+
+TEST_P(scanned, control_character_is_found_at_every_offset)
+{
+	net::request_view Request;
+
+	// Offsets cover every lane of both vectors and the scalar tail after them
+	for (std::size_t Offset = 0; Offset < Long.size(); Offset += 1)
+	{
+		std::string Value = Long;
+
+		Value[Offset] = '\x01';
+		ASSERT_EQ(net::parse("GET / HTTP/1.1\r\nX: " + Value + "\r\n\r\n", Request), net::framing::invalid) << Offset;
+		Value[Offset] = '\x7f';
+		ASSERT_EQ(net::parse("GET / HTTP/1.1\r\nX: " + Value + "\r\n\r\n", Request), net::framing::invalid) << Offset;
+		Value[Offset] = '\t';
+		ASSERT_EQ(net::parse("GET / HTTP/1.1\r\nX: " + Value + "\r\n\r\n", Request), net::framing::complete) << Offset;
+		Value[Offset] = '\xe9';
+		ASSERT_EQ(net::parse("GET / HTTP/1.1\r\nX: " + Value + "\r\n\r\n", Request), net::framing::complete) << Offset;
+		EXPECT_EQ(Request.header("X"), Value);
+	}
+}
+
+TEST_P(scanned, delimiter_is_found_at_every_offset)
+{
+	net::request_view Request;
+
+	for (std::size_t Length = 1; Length < Long.size(); Length += 1)
+	{
+		const std::string Name = std::string(Length, 'n');
+
+		ASSERT_EQ(net::parse("GET /" + Long.substr(0, Length) + " HTTP/1.1\r\n" + Name + ":x\r\n\r\n", Request), net::framing::complete) << Length;
+		EXPECT_EQ(Request.target.size(), Length + 1);
+		EXPECT_EQ(Request.headers[0].name, Name);
+	}
+}
+
+TEST_P(scanned, malformed_request_line_is_invalid)
+{
+	net::request_view Request;
+
+	EXPECT_EQ(net::parse("G(T / HTTP/1.1\r\n\r\n", Request), net::framing::invalid);
+	EXPECT_EQ(net::parse("GET  HTTP/1.1\r\n\r\n", Request), net::framing::invalid);
+	EXPECT_EQ(net::parse("GET / HTTP/2.0\r\n\r\n", Request), net::framing::invalid);
+	EXPECT_EQ(net::parse("GET / HTTP/1.1\r\nBad Name: x\r\n\r\n", Request), net::framing::invalid);
+	EXPECT_EQ(net::parse("GET / HTTP/1.1\r\n: x\r\n\r\n", Request), net::framing::invalid);
+}
+
+TEST_P(scanned, too_many_headers_are_too_large)
+{
+	std::string Data = "GET / HTTP/1.1\r\n";
+	net::request_view Request;
+
+	for (std::size_t Index = 0; Index < net::request_view::MaxHeaders; Index += 1)
+		Data += "X-" + std::to_string(Index) + ": y\r\n";
+	ASSERT_EQ(net::parse(Data + "\r\n", Request), net::framing::complete);
+	EXPECT_EQ(Request.header_count, net::request_view::MaxHeaders);
+	EXPECT_EQ(net::parse(Data + "X: y\r\n\r\n", Request), net::framing::too_large);
+}
+
+TEST_P(scanned, keep_alive_follows_version_and_connection)
+{
+	net::request_view Request;
+
+	ASSERT_EQ(net::parse("GET / HTTP/1.0\r\n\r\n", Request), net::framing::complete);
+	EXPECT_FALSE(Request.keep_alive);
+	ASSERT_EQ(net::parse("GET / HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n", Request), net::framing::complete);
+	EXPECT_TRUE(Request.keep_alive);
+	ASSERT_EQ(net::parse("GET / HTTP/1.1\r\nConnection: upgrade, close\r\n\r\n", Request), net::framing::complete);
+	EXPECT_FALSE(Request.keep_alive);
+}
+
+INSTANTIATE_TEST_SUITE_P(http, scanned, ::testing::Values(net::scan::scalar, net::scan::sse42, net::scan::avx2),
+	[](::testing::TestParamInfo<net::scan> const& Info) -> std::string {
+		switch (Info.param)
+		{
+			case net::scan::sse42:
+				return "sse42";
+			case net::scan::avx2:
+				return "avx2";
+			default:
+				return "scalar";
+		}
+	});
+
+TEST(http, scalar_scan_is_always_available)
+{
+	const net::scan Previous = net::get_scan();
+
+	EXPECT_TRUE(net::set_scan(net::scan::scalar));
+	EXPECT_EQ(net::get_scan(), net::scan::scalar);
+	net::set_scan(Previous);
+}
@@ -0,0 +1,148 @@
+# include <gtest/gtest.h>
+
+# include <netordering/ring.hpp>
+
+# include <numeric>
+# include <thread>
+# include <vector>
+
+TEST(ring, keeps_order_across_wraparound)
+{
+	net::ring<std::size_t> Ring(64);
+	std::size_t Next = 0;
+	std::size_t Expected = 0;
+
+	// Half of the segment at a time, so positions go round it many times
+	for (std::size_t Round = 0; Round < 100; Round += 1)
+	{
+		for (std::size_t Index = 0; Index < 32; Index += 1, Next += 1)
+			ASSERT_TRUE(Ring.try_push(Next, 64));
+		for (std::size_t Index = 0; Index < 32; Index += 1, Expected += 1)
+		{
+			std::optional<std::size_t> Value = Ring.pop();
+
+			ASSERT_TRUE(Value.has_value());
+			ASSERT_EQ(*Value, Expected);
+		}
+	}
+	EXPECT_TRUE(Ring.empty());
+	EXPECT_FALSE(Ring.pop().has_value());
+}
+
+TEST(ring, grows_without_limit_and_reuses_segments)
+{
+	net::ring<std::size_t> Ring(64);
+
+	// Every round is deeper than the first segment, so segments are linked, drained and taken again
+	for (std::size_t Round = 0; Round < 10; Round += 1)
+	{
+		for (std::size_t Index = 0; Index < 1000; Index += 1)
+		{
+			std::size_t Value = Round * 1000 + Index;
+
+			ASSERT_TRUE(Ring.try_push(Value, 0));
+		}
+		ASSERT_EQ(Ring.size(), 1000u);
+		for (std::size_t Index = 0; Index < 1000; Index += 1)
+		{
+			std::optional<std::size_t> Value = Ring.pop();
+
+			ASSERT_TRUE(Value.has_value());
+			ASSERT_EQ(*Value, Round * 1000 + Index);
+		}
+		ASSERT_TRUE(Ring.empty());
+	}
+}
+
+TEST(ring, try_push_stops_at_limit)
+{
+	net::ring<std::size_t> Ring(8);
+	std::size_t Value = 0;
+
+	for (; Value < 8; Value += 1)
+		ASSERT_TRUE(Ring.try_push(Value, 8));
+	EXPECT_FALSE(Ring.try_push(Value, 8));
+	EXPECT_EQ(Ring.size(), 8u);
+}
+
+TEST(ring, bulk_push_takes_first_values_up_to_limit)
+{
+	net::ring<std::size_t> Ring(16);
+	std::vector<std::size_t> Values(10);
+
+	std::iota(Values.begin(), Values.end(), 0);
+	EXPECT_EQ(Ring.try_push_bulk(Values, 16), 10u);
+
+	std::iota(Values.begin(), Values.end(), 10);
+	EXPECT_EQ(Ring.try_push_bulk(Values, 16), 6u);
+	// Values which are not taken are left to caller
+	EXPECT_EQ(Values[6], 16u);
+	EXPECT_EQ(Values[9], 19u);
+
+	EXPECT_EQ(Ring.try_push_bulk(Values, 16), 0u);
+	for (std::size_t Expected = 0; Expected < 16; Expected += 1)
+		EXPECT_EQ(Ring.pop(), Expected);
+	EXPECT_FALSE(Ring.pop().has_value());
+}
+
+TEST(ring, bulk_push_crosses_segments)
+{
+	net::ring<std::size_t> Ring(64);
+	std::vector<std::size_t> Values(150);
+
+	std::iota(Values.begin(), Values.end(), 0);
+	ASSERT_EQ(Ring.try_push_bulk(Values, 0), 150u);
+	for (std::size_t Expected = 0; Expected < 150; Expected += 1)
+		ASSERT_EQ(Ring.pop(), Expected);
+}
+
+TEST(ring, concurrent_producers_and_consumers_keep_every_value)
+{
+	static constexpr std::size_t Producers = 4;
+	static constexpr std::size_t Consumers = 4;
+	static constexpr std::size_t PerProducer = 50000;
+
+	net::ring<std::size_t> Ring(256);
+	std::atomic<std::size_t> Popped(0);
+	std::atomic<std::size_t> Sum(0);
+	std::vector<std::thread> Threads;
+
+	for (std::size_t Producer = 0; Producer < Producers; Producer += 1)
+		Threads.emplace_back([&Ring, Producer](void) -> void {
+			for (std::size_t Index = 0; Index < PerProducer; Index += 1)
+			{
+				std::size_t Value = Producer * PerProducer + Index;
+
+				// Bulk and single pushes race with each other
+				if (Index % 2 == 0)
+					while (!Ring.try_push(Value, 1024))
+						std::this_thread::yield();
+				else
+				{
+					std::vector<std::size_t> Values{ Value };
+
+					while (Ring.try_push_bulk(Values, 1024) == 0)
+						std::this_thread::yield();
+				}
+			}
+		});
+	for (std::size_t Consumer = 0; Consumer < Consumers; Consumer += 1)
+		Threads.emplace_back([&Ring, &Popped, &Sum](void) -> void {
+			while (Popped.load(std::memory_order_relaxed) < Producers * PerProducer)
+				if (std::optional<std::size_t> Value = Ring.pop())
+				{
+					Sum.fetch_add(*Value, std::memory_order_relaxed);
+					Popped.fetch_add(1, std::memory_order_relaxed);
+				}
+				else
+					std::this_thread::yield();
+		});
+	for (std::thread& Thread : Threads)
+		Thread.join();
+
+	const std::size_t Count = Producers * PerProducer;
+
+	EXPECT_EQ(Popped.load(), Count);
+	EXPECT_EQ(Sum.load(), Count * (Count - 1) / 2);
+	EXPECT_TRUE(Ring.empty());
+}